@@ -33,24 +33,31 @@ vector<long> Garbage_Collector_Greedy::get_relevant_gc_candidates(int package_id
 }
 
 Block* Garbage_Collector_Greedy::choose_gc_victim(int package_id, int die_id, int klass) const {
+	return Geometry_Dispatch::call([&](auto geometry) { return choose_gc_victim(package_id, die_id, klass, geometry); });
+}
+
+template <class Geometry>
+Block* Garbage_Collector_Greedy::choose_gc_victim(int package_id, int die_id, int klass, Geometry) const {
 	vector<long> candidates = get_relevant_gc_candidates(package_id, die_id, klass);
-	uint min_valid_pages = BLOCK_SIZE;
+	uint min_valid_pages = Geometry::block_size();
 	Block* best_block = NULL;
 	for (auto physical_address : candidates) {
-		Address a = Address(physical_address, BLOCK);
+		Address a;
+		Geometry::decode(physical_address, a);
 		Block* block = ssd->get_package(a.package)->get_die(a.die)->get_plane(a.plane)->get_block(a.block);
 		if (block->get_pages_valid() < min_valid_pages && (block->get_state() == ACTIVE || block->get_state() == INACTIVE)) {
 			min_valid_pages = block->get_pages_valid();
 			best_block = block;
-			assert(min_valid_pages < BLOCK_SIZE);
+			assert(min_valid_pages < Geometry::block_size());
 		}
 	}
 
 	return best_block;
 }
 
+// Both overwrites and trims invalidate the page at the replace address, making its block a candidate
 void Garbage_Collector_Greedy::register_event_completion(Event const& event) {
-	if (event.get_event_type() != WRITE) {
+	if (event.get_event_type() != WRITE && event.get_event_type() != TRIM) {
 		return;
 	}
 	Address ra = event.get_replace_address();
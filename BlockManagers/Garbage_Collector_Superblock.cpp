@@ -0,0 +1,177 @@
+#include "../ssd.h"
+#include "../block_management.h"
+using namespace ssd;
+
+Garbage_Collector_Superblock::Garbage_Collector_Superblock()
+	:  Garbage_Collector(),
+	   gc_candidates(),
+	   victims()
+{}
+
+Garbage_Collector_Superblock::Garbage_Collector_Superblock(Ssd* ssd, Block_manager_parent* bm)
+	:  Garbage_Collector(ssd, bm),
+	   gc_candidates(),
+	   victims()
+{}
+
+Block* Garbage_Collector_Superblock::get_block(int superblock_id, int package, int die) const {
+	Address a = Block_manager_superblock::get_member(superblock_id, package, die);
+	return ssd->get_package(a.package)->get_die(a.die)->get_plane(a.plane)->get_block(a.block);
+}
+
+bool Garbage_Collector_Superblock::has_unchosen_members() const {
+	for (auto const& victim : victims) {
+		for (auto const& channel : victim.second) {
+			for (auto const& m : channel) {
+				if (m.state == NOT_CHOSEN) {
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+// The superblock with the fewest valid pages among those whose blocks are all written. Its valid pages must all
+// fit in the pages available for new writes, since they are reserved as soon as its first block is chosen.
+int Garbage_Collector_Superblock::choose_victim_superblock() const {
+	int best_superblock = UNDEFINED;
+	int min_valid_pages = SSD_SIZE * PACKAGE_SIZE * BLOCK_SIZE;
+	for (int superblock_id : gc_candidates) {
+		int num_valid_pages = 0;
+		bool is_written = true;
+		for (uint package = 0; package < SSD_SIZE && is_written; package++) {
+			for (uint die = 0; die < PACKAGE_SIZE && is_written; die++) {
+				Block* block = get_block(superblock_id, package, die);
+				is_written = block->get_state() == ACTIVE || block->get_state() == INACTIVE;
+				num_valid_pages += block->get_pages_valid();
+			}
+		}
+		if (is_written && num_valid_pages < min_valid_pages) {
+			min_valid_pages = num_valid_pages;
+			best_superblock = superblock_id;
+		}
+	}
+	if (best_superblock != UNDEFINED && bm->get_num_pages_available_for_new_writes() < min_valid_pages) {
+		return UNDEFINED;
+	}
+	return best_superblock;
+}
+
+// The blocks of the current victim are chosen first. A new victim is only chosen once they all have been,
+// and then its block with the fewest valid pages in the given package or die goes first.
+Block* Garbage_Collector_Superblock::choose_gc_victim(int package_id, int die_id, int klass) const {
+	int first_package = package_id == UNDEFINED ? 0 : package_id;
+	int num_packages = package_id == UNDEFINED ? SSD_SIZE : package_id + 1;
+	int first_die = die_id == UNDEFINED ? 0 : die_id;
+	int num_dies = die_id == UNDEFINED ? PACKAGE_SIZE : die_id + 1;
+	for (auto const& victim : victims) {
+		for (int package = first_package; package < num_packages; package++) {
+			for (int die = first_die; die < num_dies; die++) {
+				if (victim.second[package][die].state == NOT_CHOSEN) {
+					return get_block(victim.first, package, die);
+				}
+			}
+		}
+	}
+	if (has_unchosen_members()) {
+		return NULL;
+	}
+	int superblock_id = choose_victim_superblock();
+	if (superblock_id == UNDEFINED) {
+		return NULL;
+	}
+	Block* best_block = NULL;
+	for (int package = first_package; package < num_packages; package++) {
+		for (int die = first_die; die < num_dies; die++) {
+			Block* block = get_block(superblock_id, package, die);
+			if (best_block == NULL || block->get_pages_valid() < best_block->get_pages_valid()) {
+				best_block = block;
+			}
+		}
+	}
+	return best_block;
+}
+
+// When the first block of a superblock is chosen, the pages to migrate the other blocks are reserved, so that
+// application writes cannot use up the space needed to finish freeing the superblock. Garbage collection is then
+// requested in the dies of the other blocks.
+void Garbage_Collector_Superblock::commit_choice_of_victim(Address const& phys_address, double time) {
+	int superblock_id = Block_manager_superblock::get_superblock_id(phys_address);
+	if (victims.count(superblock_id) == 0) {
+		gc_candidates.erase(superblock_id);
+		victims[superblock_id] = vector<vector<member> >(SSD_SIZE, vector<member>(PACKAGE_SIZE));
+		int num_reserved_pages = 0;
+		for (uint package = 0; package < SSD_SIZE; package++) {
+			for (uint die = 0; die < PACKAGE_SIZE; die++) {
+				if (package != phys_address.package || die != phys_address.die) {
+					member& m = victims[superblock_id][package][die];
+					m.num_reserved_pages = get_block(superblock_id, package, die)->get_pages_valid();
+					num_reserved_pages += m.num_reserved_pages;
+				}
+			}
+		}
+		bm->subtract_from_available_for_new_writes(num_reserved_pages);
+		for (uint package = 0; package < SSD_SIZE; package++) {
+			for (uint die = 0; die < PACKAGE_SIZE; die++) {
+				if (package != phys_address.package || die != phys_address.die) {
+					bm->schedule_gc(time, package, die, UNDEFINED, UNDEFINED);
+				}
+			}
+		}
+	}
+	// The migrator takes the pages it needs for this block once it is committed, so its reservation is given back
+	member& m = victims[superblock_id][phys_address.package][phys_address.die];
+	assert(m.state == NOT_CHOSEN);
+	bm->subtract_from_available_for_new_writes(-m.num_reserved_pages);
+	m.num_reserved_pages = 0;
+	m.state = CHOSEN;
+}
+
+int Garbage_Collector_Superblock::get_num_pages_reserved_for(Block const& victim) const {
+	Address a = Address(victim.get_physical_address(), BLOCK);
+	auto victim_it = victims.find(Block_manager_superblock::get_superblock_id(a));
+	return victim_it == victims.end() ? 0 : victim_it->second[a.package][a.die].num_reserved_pages;
+}
+
+// Pages invalidated in a superblock make it a candidate, unless it is already being garbage-collected.
+// When a block of a victim is erased, its die can garbage-collect again, so the blocks of the victims that
+// could not be chosen yet are requested again.
+void Garbage_Collector_Superblock::register_event_completion(Event const& event) {
+	if (event.get_event_type() == ERASE) {
+		Address const& a = event.get_address();
+		auto victim_it = victims.find(Block_manager_superblock::get_superblock_id(a));
+		if (victim_it == victims.end()) {
+			return;
+		}
+		victim_it->second[a.package][a.die].state = ERASED;
+		bool is_erased = true;
+		for (uint package = 0; package < SSD_SIZE; package++) {
+			for (uint die = 0; die < PACKAGE_SIZE; die++) {
+				is_erased = is_erased && victim_it->second[package][die].state == ERASED;
+				if (victim_it->second[package][die].state == NOT_CHOSEN) {
+					bm->schedule_gc(event.get_current_time(), package, die, UNDEFINED, UNDEFINED);
+				}
+			}
+		}
+		if (is_erased) {
+			victims.erase(victim_it);
+		}
+		return;
+	}
+	if (event.get_event_type() != WRITE && event.get_event_type() != TRIM) {
+		return;
+	}
+	Address ra = event.get_replace_address();
+	if (ra.valid == NONE) {
+		return;
+	}
+	int superblock_id = Block_manager_superblock::get_superblock_id(ra);
+	if (victims.count(superblock_id) == 1) {
+		return;
+	}
+	gc_candidates.insert(superblock_id);
+	if (gc_candidates.size() == 1) {
+		bm->check_if_should_trigger_more_GC(event);
+	}
+}
@@ -208,12 +208,12 @@ bool Migrator::copy_back_allowed_on(long logical_address) {
 }
 
 // Updates map keeping track of performed copy backs for each logical address
-void Migrator::register_copy_back_operation_on(uint logical_address) {
+void Migrator::register_copy_back_operation_on(ulong logical_address) {
 	page_copy_back_count[logical_address]++; // Increment copy back counter for target page (if address is not yet in map, it will be inserted and count will become 1)
 }
 
 // Signals than an ECC check has been performed on a page, meaning that it can be copy backed again in the future
-void Migrator::register_ECC_check_on(uint logical_address) {
+void Migrator::register_ECC_check_on(ulong logical_address) {
 	page_copy_back_count.erase(logical_address);
 }
 
@@ -225,6 +225,37 @@ void Migrator::update_structures(Address const& a, double time) {
 	StatisticsGatherer::get_global_instance()->register_executed_gc(*victim);
 }
 
+// For FTLs that choose which blocks to reclaim themselves, like FAST after a merge. A fully written block is erased once
+// its last valid page is invalidated, or right away if it has none. Blocks that still have free pages are left alone.
+void Migrator::erase_once_invalid(Address const& a, double time) {
+	Block* block = ssd->get_package(a.package)->get_die(a.die)->get_plane(a.plane)->get_block(a.block);
+	if (block->get_pages_valid() + block->get_pages_invalid() < BLOCK_SIZE) {
+		return;
+	}
+	Address block_address = Address(block->get_physical_address(), BLOCK);
+	update_structures(block_address, time);
+	if (block->get_state() == INACTIVE) {
+		blocks_being_garbage_collected[block->get_physical_address()]--;
+		issue_erase(block_address, time);
+	}
+}
+
+// For FTLs whose host discards whole blocks, like the zone resets of the ZNS FTL. The pages that are still valid are
+// invalidated, and the block is erased right away, even if it is not fully written.
+void Migrator::erase_block(Address const& a, double time) {
+	Block* block = ssd->get_package(a.package)->get_die(a.die)->get_plane(a.plane)->get_block(a.block);
+	bm->register_unwritten_pages_erased(BLOCK_SIZE - block->get_pages_valid() - block->get_pages_invalid());
+	for (uint i = 0; i < BLOCK_SIZE && block->get_pages_valid() > 0; i++) {
+		if (block->get_page(i).get_state() == VALID) {
+			block->invalidate_page(i);
+		}
+	}
+	// The erase is issued right away, so no trim may issue it again. It is not counted as a garbage collection.
+	blocks_being_garbage_collected[block->get_physical_address()] = -1;
+	num_blocks_being_garbaged_collected_per_LUN[a.package][a.die]++;
+	issue_erase(Address(block->get_physical_address(), BLOCK), time);
+}
+
 vector<deque<Event*> > Migrator::migrate(Event* gc_event) {
 	Address a = gc_event->get_address();
 	vector<deque<Event*> > migrations;
@@ -261,7 +292,7 @@ vector<deque<Event*> > Migrator::migrate(Event* gc_event) {
 		return migrations;
 	}
 
-	if (bm->get_num_pages_available_for_new_writes() < victim->get_pages_valid()) {
+	if (bm->get_num_pages_available_for_new_writes() + gc->get_num_pages_reserved_for(*victim) < victim->get_pages_valid()) {
 		StatisticsGatherer::get_global_instance()->num_gc_cancelled_not_enough_free_space++;
 		return migrations;
 	}
@@ -152,7 +152,7 @@ int tag_detector::which_group_should_this_page_belong_to(Event const& event) {
 	if (event.get_tag() != UNDEFINED) {
 		return event.get_tag();
 	}
-	int la = event.get_logical_address();
+	long la = event.get_logical_address();
 	int smallest_non_matching_group = UNDEFINED;
 	for (int i = 0; i < groups.size(); i++) {
 		if (la >= groups[i].offset && la < groups[i].offset + groups[i].size + i) {
@@ -173,7 +173,7 @@ void Block_Manager_Groups::register_write_outcome(Event const& event, enum statu
 
 	Block_manager_parent::register_write_outcome(event, status);
 
-	int la = event.get_logical_address();
+	long la = event.get_logical_address();
 	int prior_group_id = group::mapping_pages_to_groups.at(la);
 	int ideal_group_id = detector->which_group_should_this_page_belong_to(event);
 	if (ideal_group_id == 1) {
@@ -253,7 +253,7 @@ void Block_Manager_Groups::register_write_outcome(Event const& event, enum statu
 	group::num_writes_since_last_regrouping++;
 
 	static int count = 0;
-	int lba = NUMBER_OF_ADDRESSABLE_PAGES() * OVER_PROVISIONING_FACTOR;
+	long lba = NUMBER_OF_ADDRESSABLE_PAGES() * OVER_PROVISIONING_FACTOR;
 	if (event.is_original_application_io()) {
 		count++;
 	}
@@ -1185,7 +1185,7 @@ void bloom_detector::group_interval_finished(int group_id) {
 }
 
 void bloom_detector::change_id_for_pages(int old_id, int new_id) {
-	for (int i = 0; i < group::mapping_pages_to_groups.size(); i++) {
+	for (ulong i = 0; i < group::mapping_pages_to_groups.size(); i++) {
 		if (group::mapping_pages_to_groups[i] == old_id) {
 			group::mapping_pages_to_groups[i] = new_id;
 		}
@@ -144,10 +144,10 @@ void Block_manager_parent::register_erase_outcome(Event& event, enum status stat
 	}
 
 	uint age_class = sort_into_age_class(a);
-	free_blocks[a.package][a.die][age_class].push_back(a);
+	uint num_blocks_freed = add_free_block(a, age_class);
 
-	num_free_pages += BLOCK_SIZE;
-	num_available_pages_for_new_writes += BLOCK_SIZE;
+	num_free_pages += num_blocks_freed * BLOCK_SIZE;
+	num_available_pages_for_new_writes += num_blocks_freed * BLOCK_SIZE;
 	//printf("%d   %d\n", num_available_pages_for_new_writes, num_free_pages);
 	Free_Space_Meter::register_num_free_pages_for_app_writes(num_available_pages_for_new_writes, event.get_current_time());
 
@@ -159,6 +159,17 @@ void Block_manager_parent::register_erase_outcome(Event& event, enum status stat
 
 }
 
+// Erased blocks can be written again right away. BMs that allocate blocks in groups may hold them back until the
+// whole group is erased. Returns the number of blocks that became free.
+uint Block_manager_parent::add_free_block(Address const& block, uint age_class) {
+	free_blocks[block.package][block.die][age_class].push_back(block);
+	return 1;
+}
+
+void Block_manager_parent::schedule_gc(double time, int package_id, int die_id, int block, int klass) {
+	migrator->schedule_gc(time, package_id, die_id, block, klass);
+}
+
 void Block_manager_parent::register_write_arrival(Event const& write) {
 
 }
@@ -289,13 +300,19 @@ bool Block_manager_parent::can_write(Event const& write) const {
 }
 
 void Block_manager_parent::check_if_should_trigger_more_GC(Event const& event) {
-	if (num_free_pages <= BLOCK_SIZE) {
+	Geometry_Dispatch::call([&](auto geometry) { check_if_should_trigger_more_GC(event, geometry); });
+}
+
+// This runs after every write, so with a fixed geometry the loop over the LUNs is unrolled
+template <class Geometry>
+void Block_manager_parent::check_if_should_trigger_more_GC(Event const& event, Geometry) {
+	if (num_free_pages <= Geometry::block_size()) {
 		migrator->schedule_gc(event.get_current_time(), -1, -1, -1, -1);
 	}
 
-	int num_luns_with_space = SSD_SIZE * PACKAGE_SIZE;
-	for (uint i = 0; i < SSD_SIZE; i++) {
-		for (uint j = 0; j < PACKAGE_SIZE; j++) {
+	int num_luns_with_space = Geometry::ssd_size() * Geometry::package_size();
+	for (uint i = 0; i < Geometry::ssd_size(); i++) {
+		for (uint j = 0; j < Geometry::package_size(); j++) {
 			if (!has_free_pages(free_block_pointers[i][j]) || get_num_free_blocks(i, j) < GREED_SCALE) {
 				migrator->schedule_gc(event.get_current_time(), i, j, -1, -1);
 			}
@@ -311,16 +328,24 @@ void Block_manager_parent::check_if_should_trigger_more_GC(Event const& event) {
 // it finds the die with the shortest queue, and returns its ID
 // if all dies are busy, the boolean field is returned as false
 pair<bool, pair<int, int> > Block_manager_parent::get_free_block_pointer_with_shortest_IO_queue(vector<vector<Address> > const& dies) const {
+	return get_free_block_pointer_with_shortest_IO_queue(dies, Runtime_Geometry());
+}
+
+// With a fixed geometry, the vector of channels must span the whole SSD, as the free block pointers do
+template <class Geometry>
+pair<bool, pair<int, int> > Block_manager_parent::get_free_block_pointer_with_shortest_IO_queue(vector<vector<Address> > const& dies, Geometry) const {
 	uint best_channel_id = UNDEFINED;
 	uint best_die_id = UNDEFINED;
 	bool can_write = false;
 	bool at_least_one_address = false;
 	double shortest_time = std::numeric_limits<double>::max( );
 	//for (uint i = 0; i < dies.size(); i++) {
-	for (int i = dies.size() - 1; i >= 0; i--) {
+	int num_channels = Geometry::is_fixed ? Geometry::ssd_size() : dies.size();
+	for (int i = num_channels - 1; i >= 0; i--) {
 		double earliest_die_finish_time = std::numeric_limits<double>::max();
 		uint die_with_earliest_finish_time = 0;
-		for (uint j = 0; j < dies[i].size(); j++) {
+		uint num_dies = Geometry::is_fixed ? Geometry::package_size() : dies[i].size();
+		for (uint j = 0; j < num_dies; j++) {
 		//for (int j = dies[i].size() - 1; j >= 0; j--) {
 			Address pointer = dies[i][j];
 			at_least_one_address = at_least_one_address ? at_least_one_address : pointer.valid == PAGE;
@@ -354,7 +379,8 @@ pair<bool, pair<int, int> > Block_manager_parent::get_free_block_pointer_with_sh
 Address Block_manager_parent::get_free_block_pointer_with_shortest_IO_queue() {
 	pair<bool, pair<int, int> > best_die;
 	if (IO_has_completed_since_last_shortest_queue_search) {
-	    best_die = get_free_block_pointer_with_shortest_IO_queue(free_block_pointers);
+		assert(free_block_pointers.size() == SSD_SIZE);
+		best_die = Geometry_Dispatch::call([&](auto geometry) { return get_free_block_pointer_with_shortest_IO_queue(free_block_pointers, geometry); });
 		last_get_free_block_pointer_with_shortest_IO_queue_result = best_die;
 		IO_has_completed_since_last_shortest_queue_search = false;
 	} else {
@@ -598,6 +624,7 @@ Block_manager_parent* Block_manager_parent::get_new_instance() {
 		case 5: bm = new Block_Manager_Tag_Groups(); break;
 		case 6: bm = new Block_Manager_Groups(); break;
 		case 7: bm = new bm_gc_locality(); break;
+		case 8: bm = new Block_manager_superblock(); break;
 		default: bm = new Block_manager_parallel(); break;
 	}
 	return bm;
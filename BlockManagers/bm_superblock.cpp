@@ -0,0 +1,90 @@
+/*
+ * bm_superblock.cpp
+ *
+ *  A block manager that allocates and erases a block in every die at a time
+ */
+
+#include <new>
+#include <assert.h>
+#include <stdio.h>
+#include "../ssd.h"
+
+using namespace ssd;
+
+Block_manager_superblock::Block_manager_superblock()
+:	Block_manager_parent(),
+	address_cursor(),
+	num_erased_members(get_num_superblocks(), 0)
+{}
+
+// The superblock of a block is given by its index within its die
+int Block_manager_superblock::get_superblock_id(Address const& block) {
+	return block.plane * PLANE_SIZE + block.block;
+}
+
+Address Block_manager_superblock::get_member(int superblock_id, int package, int die) {
+	return Address(package, die, superblock_id / PLANE_SIZE, superblock_id % PLANE_SIZE, 0, PAGE);
+}
+
+void Block_manager_superblock::register_write_outcome(Event const& event, enum status status) {
+	if (status == FAILURE) {
+		return;
+	}
+	Block_manager_parent::register_write_outcome(event, status);
+	move_address_cursor();
+}
+
+// A superblock that has just become free gives a block to every die that has run out of space
+void Block_manager_superblock::register_erase_outcome(Event& event, enum status status) {
+	assert(event.get_event_type() == ERASE);
+	if (status == FAILURE) {
+		return;
+	}
+	Block_manager_parent::register_erase_outcome(event, status);
+	for (uint package = 0; package < SSD_SIZE; package++) {
+		for (uint die = 0; die < PACKAGE_SIZE; die++) {
+			if (has_free_pages(free_block_pointers[package][die])) {
+				continue;
+			}
+			Address block = find_free_unused_block(package, die, event.get_current_time());
+			if (has_free_pages(block)) {
+				free_block_pointers[package][die] = block;
+				Free_Space_Per_LUN_Meter::mark_new_space(block, event.get_current_time());
+			}
+		}
+	}
+	check_if_should_trigger_more_GC(event);
+}
+
+// Every die takes its free blocks in the order in which the superblocks were freed, so the dies move on to the
+// next superblock together, and the blocks of a superblock are written at the same time.
+uint Block_manager_superblock::add_free_block(Address const& block, uint age_class) {
+	int superblock_id = get_superblock_id(block);
+	num_erased_members[superblock_id]++;
+	if (num_erased_members[superblock_id] < SSD_SIZE * PACKAGE_SIZE) {
+		return 0;
+	}
+	num_erased_members[superblock_id] = 0;
+	for (uint package = 0; package < SSD_SIZE; package++) {
+		for (uint die = 0; die < PACKAGE_SIZE; die++) {
+			Address member = get_member(superblock_id, package, die);
+			free_blocks[package][die][sort_into_age_class(member)].push_back(member);
+		}
+	}
+	return SSD_SIZE * PACKAGE_SIZE;
+}
+
+Address Block_manager_superblock::choose_best_address(Event& write) {
+	return free_block_pointers[address_cursor.package][address_cursor.die];
+}
+
+// Used when the die under the cursor has no free pages, until its next superblock is freed
+Address Block_manager_superblock::choose_any_address(Event const& write) {
+	return get_free_block_pointer_with_shortest_IO_queue();
+}
+
+// Consecutive writes go to different channels, and then to the next die of each channel
+void Block_manager_superblock::move_address_cursor() {
+	address_cursor.package = (address_cursor.package + 1) % SSD_SIZE;
+	if (address_cursor.package == 0) address_cursor.die = (address_cursor.die + 1) % PACKAGE_SIZE;
+}
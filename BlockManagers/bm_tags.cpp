@@ -158,7 +158,7 @@ void Block_Manager_Tag_Groups::print() const{
 					int tag = UNDEFINED;
 					for (int pa = 0; pa < BLOCK_SIZE; pa++) {
 						Address a = Address(p, d, pl, b, pa, PAGE);
-						int la = ftl->get_logical_address(a.get_linear_address());
+						long la = ftl->get_logical_address(a.get_linear_address());
 						if (la == UNDEFINED) {
 							continue;
 						}
@@ -101,7 +101,7 @@ void group::print() const {
 
 void group::print_tags_per_group() const {
 	map<int, int> tag_map;
-	for (int i = 0; i < mapping_pages_to_groups.size(); i++) {
+	for (ulong i = 0; i < mapping_pages_to_groups.size(); i++) {
 		if (mapping_pages_to_groups[i] == index) {
 			int tag = mapping_pages_to_tags[i];
 			tag_map[tag]++;
@@ -358,7 +358,7 @@ void group::print(vector<group> const& groups) {
 void group::print_tags_distribution(vector<group> const& groups) {
 	map<int, int> tag_to_total;
 	vector<map<int, int> > per_group(groups.size(), map<int, int>());
-	for (int i = 0; i < mapping_pages_to_groups.size(); i++) {
+	for (ulong i = 0; i < mapping_pages_to_groups.size(); i++) {
 		int tag = mapping_pages_to_tags[i];
 		tag_to_total[tag]++;
 		int group_id = mapping_pages_to_groups[i];
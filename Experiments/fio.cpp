@@ -0,0 +1,39 @@
+#include "../ssd.h"
+using namespace ssd;
+
+// Runs the jobs of a fio job file on the simulated SSD, and prints the results in fio's JSON format.
+// Usage: fio <job file> [SSD configuration file] [JSON output file]
+// Without a configuration file, the small SSD configuration is used. Without an output file, the JSON is printed last on stdout.
+// The logical address space is written sequentially before the jobs start, so that they never read unwritten pages.
+int main(int argc, char* argv[])
+{
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s <job file> [SSD configuration file] [JSON output file]\n", argv[0]);
+		return 1;
+	}
+	set_small_SSD_config();
+	if (argc > 2) {
+		load_config(argv[2]);
+	}
+	PRINT_LEVEL = 0;
+	Fio_Workload* workload = new Fio_Workload(argv[1]);
+	Simple_Thread* precondition = new Asynchronous_Sequential_Writer(0, NUMBER_OF_ADDRESSABLE_PAGES() * OVER_PROVISIONING_FACTOR);
+	precondition->add_follow_up_threads(workload->generate_instance());
+
+	OperatingSystem* os = new OperatingSystem();
+	os->set_threads(vector<Thread*>(1, precondition));
+	os->run();
+
+	FILE* output = argc > 3 ? fopen(argv[3], "w") : stdout;
+	if (output == NULL) {
+		fprintf(stderr, "Cannot open %s for writing.\n", argv[3]);
+		return 1;
+	}
+	workload->print_json(output);
+	if (output != stdout) {
+		fclose(output);
+	}
+	delete os;
+	delete workload;
+	return 0;
+}
@@ -0,0 +1,33 @@
+#include "../ssd.h"
+using namespace ssd;
+
+// Runs the IOPS, throughput and latency tests of the SNIA Solid State Storage Performance Test Specification,
+// each on a fresh SSD, and writes their CSV reports next to the usual results of each test.
+// Usage: pts [SSD configuration file] [results folder] [point duration in microseconds]
+// Without a configuration file, the small SSD configuration is used. The results folder is relative to the working directory,
+// and is pts_output by default. The PTS runs each point for a minute, which would take too long to simulate, so the points
+// are 10ms long by default.
+int main(int argc, char* argv[])
+{
+	set_small_SSD_config();
+	if (argc > 1) {
+		load_config(argv[1]);
+	}
+	PRINT_LEVEL = 0;
+	string results_folder = argc > 2 ? argv[2] : "pts_output";
+	double point_duration = argc > 3 ? atof(argv[3]) : 10000;
+	Experiment::create_base_folder("/" + results_folder + "/");
+	pts_test tests[] = { PTS_IOPS, PTS_THROUGHPUT, PTS_LATENCY };
+	for (auto test : tests) {
+		SNIA_PTS_Workload* workload = new SNIA_PTS_Workload(test, UNDEFINED, point_duration);
+		string test_name = SNIA_PTS_Results::get_test_name(test);
+		Experiment* experiment = new Experiment();
+		experiment->set_workload(workload);
+		experiment->set_io_limit(UNDEFINED);
+		experiment->run(test_name);
+		workload->write_results(Experiment::get_base_directory() + test_name + "/");
+		delete experiment;
+		delete workload;
+	}
+	return 0;
+}
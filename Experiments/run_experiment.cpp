@@ -0,0 +1,22 @@
+#include "../ssd.h"
+using namespace ssd;
+
+// Runs the experiment described by a spec file. See Experiment_Spec in ssd.h for the format.
+// Usage: run_experiment <spec file> [results folder]
+// The small SSD configuration is the starting point for the knobs in the spec. The results folder is relative to
+// the working directory, and is experiment_output by default.
+int main(int argc, char* argv[])
+{
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s <spec file> [results folder]\n", argv[0]);
+		return 1;
+	}
+	set_small_SSD_config();
+	PRINT_LEVEL = 0;
+	Experiment_Spec* spec = new Experiment_Spec(argv[1]);
+	string results_folder = argc > 2 ? argv[2] : "experiment_output";
+	Experiment::create_base_folder("/" + results_folder + "/");
+	spec->run();
+	delete spec;
+	return 0;
+}
@@ -7,12 +7,19 @@
 using namespace ssd;
 int DFTL::ENTRIES_PER_TRANSLATION_PAGE = 1024;
 bool DFTL::SEPERATE_MAPPING_PAGES = true;
+int DFTL::MAX_PREFETCH_DEPTH = 0;
 
 DFTL::DFTL(Ssd *ssd, Block_manager_parent* bm) :
 		flash_resident_page_ftl(ssd, bm),
 		ongoing_mapping_operations(),
 		application_ios_waiting_for_translation(),
-		mapping_pages(NUMBER_OF_ADDRESSABLE_PAGES() / ENTRIES_PER_TRANSLATION_PAGE)
+		mapping_pages(NUMBER_OF_ADDRESSABLE_PAGES() / ENTRIES_PER_TRANSLATION_PAGE),
+		translation_page_buffer(),
+		unused_prefetches(),
+		last_accessed_translation_page(UNDEFINED),
+		translation_page_stride(0),
+		next_translation_page_to_prefetch(UNDEFINED),
+		prefetch_depth(1)
 {
 	IS_FTL_PAGE_MAPPING = true;
 }
@@ -20,7 +27,13 @@ DFTL::DFTL(Ssd *ssd, Block_manager_parent* bm) :
 DFTL::DFTL() :
 		flash_resident_page_ftl(),
 		ongoing_mapping_operations(),
-		application_ios_waiting_for_translation()
+		application_ios_waiting_for_translation(),
+		translation_page_buffer(),
+		unused_prefetches(),
+		last_accessed_translation_page(UNDEFINED),
+		translation_page_stride(0),
+		next_translation_page_to_prefetch(UNDEFINED),
+		prefetch_depth(1)
 {
 	IS_FTL_PAGE_MAPPING = true;
 }
@@ -53,6 +66,16 @@ void DFTL::read(Event *event) {
 		return;
 	}
 
+	// If the translation page was recently read, its entries are still in SRAM
+	if (find(translation_page_buffer.begin(), translation_page_buffer.end(), translation_page_id) != translation_page_buffer.end()) {
+		if (unused_prefetches.count(translation_page_id) == 1) {
+			register_translation_page_access(translation_page_id, event->get_current_time());
+		}
+		cache->handle_read_dependency(event);
+		scheduler->schedule_event(event);
+		return;
+	}
+
 	// If there is no mapping IO currently targeting the translation page, create on. Otherwise, invoke current event when ongoing mapping IO finishes.
 	if (ongoing_mapping_operations.count(NUMBER_OF_ADDRESSABLE_PAGES() - translation_page_id) == 1) {
 		application_ios_waiting_for_translation[translation_page_id].push_back(event);
@@ -61,6 +84,93 @@ void DFTL::read(Event *event) {
 		//printf("creating mapping read %d for app write %d\n", translation_page_id, event->get_logical_address());
 		create_mapping_read(translation_page_id, event->get_current_time(), event);
 	}
+	register_translation_page_access(translation_page_id, event->get_current_time());
+}
+
+// Called for reads that miss in the mapping cache on a translation page that is not in the buffer, and for the first read that
+// needs a prefetched translation page. Once two accesses in a row have the same stride, the following translation pages with that
+// stride are prefetched, up to prefetch_depth pages ahead.
+void DFTL::register_translation_page_access(long translation_page_id, double time) {
+	if (MAX_PREFETCH_DEPTH <= 0) {
+		return;
+	}
+	if (unused_prefetches.erase(translation_page_id) == 1) {
+		register_prefetch_outcome(true);
+	}
+	if (translation_page_id == last_accessed_translation_page) {
+		return;
+	}
+	long stride = translation_page_id - last_accessed_translation_page;
+	bool is_stream = last_accessed_translation_page != UNDEFINED && stride == translation_page_stride;
+	last_accessed_translation_page = translation_page_id;
+	translation_page_stride = stride;
+	if (!is_stream) {
+		next_translation_page_to_prefetch = UNDEFINED;
+		return;
+	}
+	// The prefetching continues where it left off, unless the scan has overtaken it
+	if (next_translation_page_to_prefetch == UNDEFINED || (next_translation_page_to_prefetch - translation_page_id) / stride <= 0) {
+		next_translation_page_to_prefetch = translation_page_id + stride;
+	}
+	long num_translation_pages = mapping_pages.size();
+	while ((next_translation_page_to_prefetch - translation_page_id) / stride <= prefetch_depth &&
+			next_translation_page_to_prefetch >= 0 && next_translation_page_to_prefetch < num_translation_pages) {
+		Address translation_page = page_mapping->get_physical_address(NUMBER_OF_ADDRESSABLE_PAGES() - next_translation_page_to_prefetch);
+		// Prefetches only use idle dies, so the rest is tried again at the next access
+		if (translation_page.valid == PAGE && !is_die_idle(translation_page, time)) {
+			break;
+		}
+		prefetch_translation_page(next_translation_page_to_prefetch, time);
+		next_translation_page_to_prefetch += stride;
+	}
+}
+
+// Translation pages that were never written to flash, or that are already in SRAM or being read or written, are skipped
+void DFTL::prefetch_translation_page(long translation_page_id, double time) {
+	long mapping_address = NUMBER_OF_ADDRESSABLE_PAGES() - translation_page_id;
+	Address physical_addr_of_translation_page = page_mapping->get_physical_address(mapping_address);
+	if (physical_addr_of_translation_page.valid == NONE || ongoing_mapping_operations.count(mapping_address) == 1 ||
+			find(translation_page_buffer.begin(), translation_page_buffer.end(), translation_page_id) != translation_page_buffer.end()) {
+		return;
+	}
+	Event* mapping_event = new Event(READ, mapping_address, 1, time);
+	mapping_event->set_mapping_op(true);
+	mapping_event->set_address(physical_addr_of_translation_page);
+	application_ios_waiting_for_translation[translation_page_id] = vector<Event*>();
+	ongoing_mapping_operations.insert(mapping_address);
+	unused_prefetches.insert(translation_page_id);
+	normal_stats.num_mapping_prefetches++;
+	scheduler->schedule_event(mapping_event);
+}
+
+// The buffer is LRU, and evicting a prefetched translation page that was never used counts as a wasted prefetch
+void DFTL::insert_in_translation_page_buffer(long translation_page_id) {
+	translation_page_buffer.remove(translation_page_id);
+	translation_page_buffer.push_front(translation_page_id);
+	if ((int)translation_page_buffer.size() > 2 * MAX_PREFETCH_DEPTH) {
+		long victim = translation_page_buffer.back();
+		translation_page_buffer.pop_back();
+		if (unused_prefetches.erase(victim) == 1) {
+			register_prefetch_outcome(false);
+		}
+	}
+}
+
+// The depth grows by one with every useful prefetch, and is halved by every wasted one
+void DFTL::register_prefetch_outcome(bool was_useful) {
+	if (was_useful) {
+		normal_stats.num_useful_mapping_prefetches++;
+		prefetch_depth = min(prefetch_depth + 1, MAX_PREFETCH_DEPTH);
+	} else {
+		normal_stats.num_wasted_mapping_prefetches++;
+		prefetch_depth = max(prefetch_depth / 2, 1);
+	}
+	normal_stats.mapping_prefetch_depth = prefetch_depth;
+}
+
+bool DFTL::is_die_idle(Address const& address, double time) const {
+	Die* die = ssd->get_package(address.package)->get_die(address.die);
+	return die->get_currently_executing_io_finish_time() <= time && !die->register_is_busy();
 }
 
 void DFTL::register_read_completion(Event const& event, enum status result) {
@@ -85,6 +195,10 @@ void DFTL::register_read_completion(Event const& event, enum status result) {
 		}
 	}*/
 
+	if (MAX_PREFETCH_DEPTH > 0) {
+		insert_in_translation_page_buffer(translation_page_id);
+	}
+
 	// schedule all operations
 	vector<Event*> waiting_events = application_ios_waiting_for_translation[translation_page_id];
 	application_ios_waiting_for_translation.erase(translation_page_id);
@@ -103,12 +217,12 @@ void DFTL::register_read_completion(Event const& event, enum status result) {
 	try_clear_space_in_mapping_cache(event.get_current_time());
 }
 
-void DFTL::notify_garbage_collector(int translation_page_id, double time) {
+void DFTL::notify_garbage_collector(long translation_page_id, double time) {
 	if (gc == NULL) {
 		return;
 	}
 	long first_key_in_translation_page = translation_page_id * ENTRIES_PER_TRANSLATION_PAGE;
-	for (int i = first_key_in_translation_page;
+	for (long i = first_key_in_translation_page;
 			i < first_key_in_translation_page + ENTRIES_PER_TRANSLATION_PAGE; ++i) {
 		if (cache->contains(i) && cache->cached_mapping_table[i].synch_flag == false) {
 			Address old_address = mapping_pages[translation_page_id].entries[i];
@@ -182,7 +296,7 @@ void DFTL::register_write_completion(Event const& event, enum status result) {
 
 	mapping_pages[translation_page_id].entries.clear();
 	long first_key_in_translation_page = translation_page_id * ENTRIES_PER_TRANSLATION_PAGE;
-	for (int i = first_key_in_translation_page;
+	for (long i = first_key_in_translation_page;
 			i < first_key_in_translation_page + ENTRIES_PER_TRANSLATION_PAGE; ++i) {
 		Address a = page_mapping->get_physical_address(i);
 		mapping_pages[translation_page_id].entries[i] = a;
@@ -210,11 +324,11 @@ void DFTL::register_trim_completion(Event & event) {
 	page_mapping->register_trim_completion(event);
 }
 
-long DFTL::get_logical_address(uint physical_address) const {
+long DFTL::get_logical_address(ulong physical_address) const {
 	return page_mapping->get_logical_address(physical_address);
 }
 
-Address DFTL::get_physical_address(uint logical_address) const {
+Address DFTL::get_physical_address(ulong logical_address) const {
 	return page_mapping->get_physical_address(logical_address);
 }
 
@@ -257,7 +371,7 @@ void DFTL::set_read_address(Event& event) const {
 void DFTL::mark_clean(long translation_page_id, Event const& event) {
 	int num_dirty_entries = 0;
 	long first_key_in_translation_page = translation_page_id * ENTRIES_PER_TRANSLATION_PAGE;
-	for (int i = first_key_in_translation_page;
+	for (long i = first_key_in_translation_page;
 			i < first_key_in_translation_page + ENTRIES_PER_TRANSLATION_PAGE; ++i) {
 
 		if (cache->mark_clean(i, event.get_current_time())) {
@@ -17,12 +17,16 @@ FAST::FAST(Ssd *ssd, Block_manager_parent* bm, Migrator* migrator) :
 		full_log_blocks(),
 		queued_events(),
 		gc_queue(),
-		logical_dependencies()
+		logical_dependencies(),
+		merges_in_progress(),
+		log_blocks_being_merged(),
+		num_log_blocks_being_merged_per_die(SSD_SIZE * PACKAGE_SIZE, 0),
+		merge_stats()
 {
 	// The over-provisioned blocks serve as log blocks. We don't use all of them, though, because we need to keep
-	// reserve free blocks for garbage-collection
+	// reserve free blocks for garbage-collection. Two per die are enough, since merges are started as blocks become free.
 	int num_over_prov_blocks = NUMBER_OF_ADDRESSABLE_BLOCKS() * (1 - OVER_PROVISIONING_FACTOR);
-	NUM_LOG_BLOCKS = num_over_prov_blocks - BLOCK_SIZE * 3;
+	NUM_LOG_BLOCKS = num_over_prov_blocks - SSD_SIZE * PACKAGE_SIZE * 2;
 	if (GREED_SCALE > 0) {
 		printf("Warning: the parameter GREED_SCALE must be set to 0 for FAST. We set it to 0 here on your behalf.\n");
 	}
@@ -41,7 +45,11 @@ FAST::FAST() :
 		full_log_blocks(),
 		queued_events(),
 		gc_queue(),
-		logical_dependencies()
+		logical_dependencies(),
+		merges_in_progress(),
+		log_blocks_being_merged(),
+		num_log_blocks_being_merged_per_die(SSD_SIZE * PACKAGE_SIZE, 0),
+		merge_stats()
 {
 	IS_FTL_PAGE_MAPPING = false;
 }
@@ -139,15 +147,17 @@ void FAST::write(Event *event)
 
 void FAST::write_in_log_block(Event* event) {
 	int block_id = event->get_logical_address() / BLOCK_SIZE;
+	int page_id = event->get_logical_address() % BLOCK_SIZE;
 	// this block is mapped to an existing log block
 	if (active_log_blocks_map.count(block_id) == 1 && active_log_blocks_map.at(block_id)->addr.page < BLOCK_SIZE) {
 		log_block* log_block_id = active_log_blocks_map.at(block_id);
 		Address& log_block_addr = log_block_id->addr;
-		if (log_block_addr.get_block_id() == 1544) {
-			int i = 0;
-			i++;
+		// A write that breaks the sequence of a sequential log block ends it with a partial merge, and goes to a new log block
+		if (log_block_id->is_sequential && page_id != log_block_addr.page && try_partial_merge(block_id, log_block_id, event->get_current_time())) {
+			write_in_log_block(event);
+			return;
 		}
-		int block_id_log = log_block_addr.get_block_id();
+		log_block_id->is_sequential = log_block_id->is_sequential && page_id == log_block_addr.page;
 		event->set_address(log_block_addr);
 		log_block_addr.page++;
 		schedule(event);
@@ -173,7 +183,7 @@ void FAST::write_in_log_block(Event* event) {
 			new_addr.valid = PAGE;
 			event->set_address(new_addr);
 			new_addr.page++;
-			log_block* lb = new log_block(new_addr);
+			log_block* lb = new log_block(new_addr, page_id == 0);
 			lb->num_blocks_mapped_inside.insert(block_id);
 			active_log_blocks_map[block_id] = lb;
 			num_active_log_blocks++;
@@ -198,6 +208,7 @@ void FAST::choose_existing_log_block(Event* event) {
 			event->set_address(lb->addr);
 			lb->addr.page++;
 			lb->num_blocks_mapped_inside.insert(block_id);
+			lb->is_sequential = false;
 			active_log_blocks_map[block_id] = lb;
 			dial = (*it).first + 1;
 			schedule(event);
@@ -212,6 +223,7 @@ void FAST::choose_existing_log_block(Event* event) {
 			event->set_address(lb->addr);
 			lb->addr.page++;
 			lb->num_blocks_mapped_inside.insert(block_id);
+			lb->is_sequential = false;
 			active_log_blocks_map[block_id] = lb;
 			dial = (*it).first + 1;
 			if (event->get_id() == 32017) {
@@ -279,10 +291,8 @@ void FAST::unlock_block(Event const& event) {
 }
 
 void FAST::register_erase_completion(Event & event) {
-	if (gc_queue.empty()) {
-		release_events_there_was_no_space_for();
-		consider_doing_garbage_collection(event.get_current_time());
-	}
+	release_events_there_was_no_space_for();
+	consider_doing_garbage_collection(event.get_current_time());
 }
 
 void FAST::register_write_completion(Event const& event, enum status result) {
@@ -296,12 +306,7 @@ void FAST::register_write_completion(Event const& event, enum status result) {
 		queue<Event*>& q = gc_queue[block_id];
 		if (q.empty() && event.get_address().page == BLOCK_SIZE - 1) {
 			gc_queue.erase(block_id);
-		}
-		int size = gc_queue.size();
-		if (gc_queue.empty()) {
-			num_active_log_blocks--;
-			release_events_there_was_no_space_for();
-			consider_doing_garbage_collection(event.get_current_time());
+			finish_merge(block_id, event.get_current_time());
 		}
 		unlock_block(event);
 		return;
@@ -335,26 +340,13 @@ void FAST::register_write_completion(Event const& event, enum status result) {
 		}
 	}
 
-	// Log block is out of space. First check if a switch operation is possible.
-	if (lb->num_blocks_mapped_inside.size() == 1) {
-		// check if they are in order
-		bool in_order = true;
-		int first_logical_address = event.get_logical_address() / BLOCK_SIZE * BLOCK_SIZE;
-		for (int i = 0; i < BLOCK_SIZE; i++) {
-			Address logical_page_i = page_mapping.get_physical_address(first_logical_address + i);
-			if (!(logical_page_i.compare(log_block_addr) >= BLOCK && logical_page_i.page == i)) {
-				in_order = false;
-			}
-		}
-
-		if (in_order) {
-			translation_table[block_id] = log_block_addr;
-			num_active_log_blocks--;
-			delete lb;
-		}
-		else {
-			full_log_blocks.push(lb);
-		}
+	// Log block is out of space. If it holds the whole logical block in order, it just replaces the data block.
+	if (lb->is_sequential && merges_in_progress.count(block_id) == 0) {
+		migrator->erase_once_invalid(normal_block, event.get_current_time());
+		translation_table[block_id] = log_block_addr;
+		num_active_log_blocks--;
+		merge_stats.num_switch_merges++;
+		delete lb;
 	}
 	else {
 		full_log_blocks.push(lb);
@@ -365,85 +357,133 @@ void FAST::register_write_completion(Event const& event, enum status result) {
 }
 
 
+// Each merge needs a free block, so the merges of a log block are started as free blocks become available. Log blocks on
+// different dies are merged in parallel, but only one log block per die is merged at a time. The log blocks with the
+// fewest logical blocks mapped inside come first, since they need the fewest merges.
 void FAST::consider_doing_garbage_collection(double time) {
-	if (full_log_blocks.size() < 1 || gc_queue.size() > 0) {
-		return;
-	}
-
-	log_block* lb = full_log_blocks.top();
-	full_log_blocks.pop();
+	for (auto lb : log_blocks_being_merged) {
+		start_waiting_merges(lb, time);
+	}
+	vector<log_block*> postponed;
+	while (!full_log_blocks.empty() && bm->get_num_free_blocks() > 0) {
+		log_block* lb = full_log_blocks.top();
+		full_log_blocks.pop();
+
+		set<long> logical_blocks_to_garbage_collect;
+		bool can_merge = num_log_blocks_being_merged_per_die[get_die_id(lb->addr)] == 0;
+		Address it = lb->addr;
+		it.page = 0;
+		for (; it.page < BLOCK_SIZE && can_merge; it.page++) {
+			long page_logical_address = page_mapping.get_logical_address(it.get_linear_address());
+			if (page_logical_address == UNDEFINED) {
+				continue;
+			}
+			int logical_block_id = page_logical_address / BLOCK_SIZE;
+			// The log block cannot be merged until the data blocks are full and no other merges are targeting them
+			if (translation_table[logical_block_id].page == BLOCK_SIZE && merges_in_progress.count(logical_block_id) == 0) {
+				logical_blocks_to_garbage_collect.insert(logical_block_id);
+			} else {
+				can_merge = false;
+			}
+		}
+		if (!can_merge) {
+			postponed.push_back(lb);
+			continue;
+		}
 
-	set<long> logical_blocks_to_garbage_collect;
-	Address it = lb->addr;
-	it.page = 0;
-	for (; it.page < BLOCK_SIZE; it.page++) {
-		long page_logical_address = page_mapping.get_logical_address(it.get_linear_address());
-		if (page_logical_address == UNDEFINED) {
+		migrator->erase_once_invalid(lb->addr, time);
+		if (logical_blocks_to_garbage_collect.empty()) {
+			num_active_log_blocks--;
+			delete lb;
 			continue;
 		}
-		int logical_block_id = page_logical_address / BLOCK_SIZE;
-		Address const& normal_address = translation_table[logical_block_id];
-		if (normal_address.page == BLOCK_SIZE) {
-			logical_blocks_to_garbage_collect.insert(logical_block_id);
-		} else {
-			// in this case, the log block cannot be deleted.
-			consider_doing_garbage_collection(time);
-			full_log_blocks.push(lb);
-			return;
+
+		for (auto b : logical_blocks_to_garbage_collect) {
+			lb->blocks_to_merge.push(b);
+			merges_in_progress[b] = lb;
 		}
+		lb->num_merges_left = logical_blocks_to_garbage_collect.size();
+		num_log_blocks_being_merged_per_die[get_die_id(lb->addr)]++;
+		log_blocks_being_merged.push_back(lb);
+		start_waiting_merges(lb, time);
 	}
-
-	if (logical_blocks_to_garbage_collect.empty()) {
-		delete lb;
-		consider_doing_garbage_collection(time);
-		return;
+	for (auto lb : postponed) {
+		full_log_blocks.push(lb);
 	}
+}
 
-	for (auto b : logical_blocks_to_garbage_collect) {
-		garbage_collect(b, lb, time);
+void FAST::start_waiting_merges(log_block* lb, double time) {
+	while (!lb->blocks_to_merge.empty()) {
+		Address new_addr = bm->find_free_unused_block(time);
+		if (new_addr.valid == NONE) {
+			return;
+		}
+		new_addr.valid = PAGE;
+		new_addr.page = 0;
+		merge(lb->blocks_to_merge.front(), new_addr, lb, time);
+		lb->blocks_to_merge.pop();
+		merge_stats.num_full_merges++;
 	}
-
-	delete lb;
 }
 
-// TODO: an optimization is possible here. When rewriting a block, the reads are on different blocks. Issue them in parallel
-void FAST::garbage_collect(int block_id, log_block* log_block, double time) {
-	Address new_addr = bm->find_free_unused_block(time);
-	assert(queued_events.count(new_addr.get_block_id()) == 0);
-	if (new_addr.valid < BLOCK) {
-		printf("We ran out of free available log blocks. We are now stuck because we cannot complete gabrage collection.");
-		printf("Try to increase over-provisioning.");
-	}
-	assert(new_addr.valid >= BLOCK);
+// The pages of a sequential log block are already in place, so only the rest of the logical block is copied into it
+// from the data block. This is only done if the data block is full, like for full merges.
+bool FAST::try_partial_merge(int block_id, log_block* lb, double time) {
+	if (merges_in_progress.count(block_id) == 1 || translation_table[block_id].page != BLOCK_SIZE) {
+		return false;
+	}
+	active_log_blocks_map.erase(block_id);
+	lb->num_merges_left = 1;
+	num_log_blocks_being_merged_per_die[get_die_id(lb->addr)]++;
+	log_blocks_being_merged.push_back(lb);
+	merge(block_id, lb->addr, lb, time);
+	merge_stats.num_partial_merges++;
+	return true;
+}
 
-	//translation_table[block_id].print();
-	//new_addr.print();
-	//printf("\t%d\n", block_id);
-	long first_logical_addr = block_id * BLOCK_SIZE;
+// Copies the pages of the logical block from the target's page onwards into the target, which becomes the data block.
+// The merges of different logical blocks run in parallel, but the pages of each one are copied in order.
+void FAST::merge(int block_id, Address const& target, log_block* lb, double time) {
+	assert(queued_events.count(target.get_block_id()) == 0 || target.page > 0);
+	long first_logical_addr = (long)block_id * BLOCK_SIZE;
 	gc_queue[block_id] = queue<Event*>();
-	for (int i = 0; i < BLOCK_SIZE; i++) {
+	for (int i = target.page; i < BLOCK_SIZE; i++) {
 		long la = first_logical_addr + i;
 
 		Event* read = new Event(READ, la, 1, time);
 		read->set_garbage_collection_op(true);
 		Event* write = new Event(WRITE, la, 1, time);
 		write->set_garbage_collection_op(true);
-		//write->set_address(new_addr);
 
 		gc_queue[block_id].push(read);
 		gc_queue[block_id].push(write);
 	}
 
-	Address& old_addr = translation_table[block_id];
-	migrator->update_structures(old_addr, time);
-	bm->subtract_from_available_for_new_writes(BLOCK_SIZE);
-	translation_table[block_id] = new_addr;
+	merges_in_progress[block_id] = lb;
+	migrator->erase_once_invalid(translation_table[block_id], time);
+	bm->subtract_from_available_for_new_writes(BLOCK_SIZE - target.page);
+	translation_table[block_id] = target;
 	Event* first_read = gc_queue[block_id].front();
 	set_read_address(*first_read);
 	gc_queue[block_id].pop();
 	scheduler->schedule_event(first_read);
 }
 
+// Once all logical blocks of a log block are merged, the log block is no longer in use
+void FAST::finish_merge(int block_id, double time) {
+	log_block* lb = merges_in_progress.at(block_id);
+	merges_in_progress.erase(block_id);
+	if (--lb->num_merges_left > 0) {
+		return;
+	}
+	num_log_blocks_being_merged_per_die[get_die_id(lb->addr)]--;
+	log_blocks_being_merged.remove(lb);
+	num_active_log_blocks--;
+	delete lb;
+	release_events_there_was_no_space_for();
+	consider_doing_garbage_collection(time);
+}
+
 
 void FAST::trim(Event *event)
 {
@@ -455,11 +495,11 @@ void FAST::register_trim_completion(Event & event) {
 	page_mapping.register_trim_completion(event);
 }
 
-long FAST::get_logical_address(uint physical_address) const {
+long FAST::get_logical_address(ulong physical_address) const {
 	return page_mapping.get_logical_address(physical_address);
 }
 
-Address FAST::get_physical_address(uint logical_address) const {
+Address FAST::get_physical_address(ulong logical_address) const {
 	return page_mapping.get_physical_address(logical_address);
 }
 
@@ -477,6 +517,9 @@ void FAST::set_read_address(Event& event) const {
 
 // used for debugging
 void FAST::print() const {
+	printf("FAST switch merges\t%ld\n", merge_stats.num_switch_merges);
+	printf("FAST partial merges\t%ld\n", merge_stats.num_partial_merges);
+	printf("FAST full merges\t%ld\n", merge_stats.num_full_merges);
 	for (auto locked_block : queued_events) {
 		printf("block: %d\n", locked_block.first);
 		queue<Event*>& q = locked_block.second;
@@ -8,7 +8,8 @@ FtlParent::FtlParent(Ssd *ssd, Block_manager_parent* bm)
 }
 
 FtlParent::~FtlParent () {
-	if (normal_stats.num_mapping_reads > 0 || normal_stats.num_mapping_writes > 0) {
+	if (normal_stats.num_mapping_reads > 0 || normal_stats.num_mapping_writes > 0 || normal_stats.num_mapping_prefetches > 0 ||
+			normal_stats.num_host_mapping_reads > 0) {
 		normal_stats.print();
 	}
 }
@@ -19,7 +20,9 @@ FtlParent::stats::stats(string name, long counter_limit) : num_mapping_reads(0),
 		app_reads_per_interval(0), app_writes_per_interval(0),
 		counter(0), num_noop_reads_per_interval(0), num_noop_writes_per_interval(0), file_name(name),
 		COUNTER_LIMIT(counter_limit), gc_mapping_reads_per_interval(0), gc_mapping_writes_per_interval(0),
-		num_noop_reads(0), num_noop_writes(0)
+		num_noop_reads(0), num_noop_writes(0), num_mapping_prefetches(0), num_useful_mapping_prefetches(0),
+		num_wasted_mapping_prefetches(0), mapping_prefetch_depth(0), num_sram_mapping_hits(0),
+		num_host_mapping_reads(0), host_link_wait_time(0)
 {}
 
 void FtlParent::stats::collect_stats(Event const& event) {
@@ -96,8 +99,56 @@ void FtlParent::collect_stats(Event const& event) {
 }
 
 void FtlParent::stats::print() const {
-	printf("FTL mapping reads\t%d\n", num_mapping_reads);
-	printf("FTL mapping writes\t%d\n", num_mapping_writes);
-	printf("FTL noop writes\t%d\n", num_noop_writes);
-	printf("FTL noop reads\t%d\n", num_noop_reads);
+	if (num_mapping_reads > 0 || num_mapping_writes > 0) {
+		printf("FTL mapping reads\t%d\n", num_mapping_reads);
+		printf("FTL mapping writes\t%d\n", num_mapping_writes);
+		printf("FTL noop writes\t%d\n", num_noop_writes);
+		printf("FTL noop reads\t%d\n", num_noop_reads);
+	}
+	// A prefetch is useful if a read needed it before it was evicted, and wasted otherwise
+	if (num_mapping_prefetches > 0) {
+		long num_resolved = num_useful_mapping_prefetches + num_wasted_mapping_prefetches;
+		printf("FTL mapping prefetches\t%ld\n", num_mapping_prefetches);
+		printf("FTL useful mapping prefetches\t%ld\n", num_useful_mapping_prefetches);
+		printf("FTL wasted mapping prefetches\t%ld\n", num_wasted_mapping_prefetches);
+		printf("FTL mapping prefetch accuracy\t%f\n", num_resolved > 0 ? num_useful_mapping_prefetches / (double)num_resolved : 0);
+		printf("FTL mapping prefetch depth\t%d\n", mapping_prefetch_depth);
+	}
+	// The wait is the time mapping reads from host memory spent queued behind other transfers on the PCIe link
+	if (num_host_mapping_reads > 0) {
+		printf("FTL SRAM mapping hits\t%ld\n", num_sram_mapping_hits);
+		printf("FTL host memory mapping reads\t%ld\n", num_host_mapping_reads);
+		printf("FTL average host link wait\t%f\n", host_link_wait_time / num_host_mapping_reads);
+	}
+}
+
+// Called by load_entry for the knobs of specific FTLs. Returns false if the name is not one of them.
+bool ssd::load_ftl_entry(const char *name, double value) {
+	if (!strcmp(name, "DFTL::ENTRIES_PER_TRANSLATION_PAGE"))
+		DFTL::ENTRIES_PER_TRANSLATION_PAGE = value;
+	else if (!strcmp(name, "DFTL::MAX_PREFETCH_DEPTH"))
+		DFTL::MAX_PREFETCH_DEPTH = value;
+	else if (!strcmp(name, "ftl_cache::CACHED_ENTRIES_THRESHOLD"))
+		ftl_cache::CACHED_ENTRIES_THRESHOLD = value;
+	else if (!strcmp(name, "FtlImpl_Page::USE_EXTENT_MAPPING"))
+		FtlImpl_Page::USE_EXTENT_MAPPING = value;
+	else if (!strcmp(name, "HMB_FTL::PCIE_ROUND_TRIP_LATENCY"))
+		HMB_FTL::PCIE_ROUND_TRIP_LATENCY = value;
+	else if (!strcmp(name, "HMB_FTL::PCIE_BANDWIDTH"))
+		HMB_FTL::PCIE_BANDWIDTH = value;
+	else if (!strcmp(name, "ZNS_FTL::MAX_OPEN_ZONES"))
+		ZNS_FTL::MAX_OPEN_ZONES = value;
+	else
+		return false;
+	return true;
+}
+
+void ssd::print_ftl_config(FILE *stream) {
+	fprintf(stream, "\tDFTL::ENTRIES_PER_TRANSLATION_PAGE: %i\n", DFTL::ENTRIES_PER_TRANSLATION_PAGE);
+	fprintf(stream, "\tDFTL::MAX_PREFETCH_DEPTH: %i\n", DFTL::MAX_PREFETCH_DEPTH);
+	fprintf(stream, "\tftl_cache::CACHED_ENTRIES_THRESHOLD: %i\n", ftl_cache::CACHED_ENTRIES_THRESHOLD);
+	fprintf(stream, "\tFtlImpl_Page::USE_EXTENT_MAPPING: %i\n", FtlImpl_Page::USE_EXTENT_MAPPING);
+	fprintf(stream, "\tHMB_FTL::PCIE_ROUND_TRIP_LATENCY: %f\n", HMB_FTL::PCIE_ROUND_TRIP_LATENCY);
+	fprintf(stream, "\tHMB_FTL::PCIE_BANDWIDTH: %f\n", HMB_FTL::PCIE_BANDWIDTH);
+	fprintf(stream, "\tZNS_FTL::MAX_OPEN_ZONES: %i\n", ZNS_FTL::MAX_OPEN_ZONES);
 }
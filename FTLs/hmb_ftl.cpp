@@ -0,0 +1,91 @@
+#include "../ssd.h"
+
+using namespace ssd;
+
+// PCIe 3.0 with 4 lanes, and the round trip of a small read from host memory
+double HMB_FTL::PCIE_ROUND_TRIP_LATENCY = 1;
+double HMB_FTL::PCIE_BANDWIDTH = 3940;
+
+HMB_FTL::HMB_FTL(Ssd *ssd, Block_manager_parent* bm) :
+		DFTL(ssd, bm),
+		sram_entries(),
+		sram_entry_positions(),
+		host_link_free_time(0)
+{}
+
+HMB_FTL::HMB_FTL() :
+		DFTL(),
+		sram_entries(),
+		sram_entry_positions(),
+		host_link_free_time(0)
+{}
+
+// A mapping entry that is in host memory but not in SRAM is fetched over the PCIe link before the read is submitted.
+// Entries that are not in host memory either are read from their translation page in flash, like in DFTL.
+void HMB_FTL::read(Event *event) {
+	long la = event->get_logical_address();
+	if (sram_entry_positions.count(la) == 1) {
+		normal_stats.num_sram_mapping_hits++;
+	} else if (cache->contains(la)) {
+		double wait = max(host_link_free_time - event->get_current_time(), 0.0);
+		event->incr_bus_wait_time(occupy_host_link(event->get_current_time(), MAPPING_ENTRY_SIZE) + PCIE_ROUND_TRIP_LATENCY);
+		normal_stats.num_host_mapping_reads++;
+		normal_stats.host_link_wait_time += wait;
+	}
+	insert_in_sram(la);
+	DFTL::read(event);
+}
+
+// The data of the write is sent over the link. It does not wait for the link itself, since the host interface is not
+// modelled for the other FTLs either, but mapping reads from host memory queue behind it.
+void HMB_FTL::write(Event *event) {
+	occupy_host_link(event->get_current_time(), PAGE_SIZE);
+	DFTL::write(event);
+}
+
+// The data of application reads goes to the host, and translation pages read from flash are copied to host memory
+void HMB_FTL::register_read_completion(Event const& event, enum status result) {
+	if (!event.get_noop() && event.is_mapping_op()) {
+		occupy_host_link(event.get_current_time(), (long)ENTRIES_PER_TRANSLATION_PAGE * MAPPING_ENTRY_SIZE);
+	} else if (!event.get_noop() && event.is_original_application_io()) {
+		occupy_host_link(event.get_current_time(), PAGE_SIZE);
+	}
+	DFTL::register_read_completion(event, result);
+}
+
+// The new mapping entry of an application write is kept in SRAM and written through to host memory.
+// A translation page that is flushed to flash is first fetched from host memory. Since DFTL creates these writes
+// internally, the transfer is accounted for when they complete.
+void HMB_FTL::register_write_completion(Event const& event, enum status result) {
+	if (!event.get_noop() && event.is_mapping_op()) {
+		occupy_host_link(event.get_current_time(), (long)ENTRIES_PER_TRANSLATION_PAGE * MAPPING_ENTRY_SIZE);
+	} else if (!event.get_noop() && event.is_original_application_io()) {
+		occupy_host_link(event.get_current_time(), MAPPING_ENTRY_SIZE);
+		insert_in_sram(event.get_logical_address());
+	}
+	DFTL::register_write_completion(event, result);
+}
+
+// Transfers on the link are serialized. Returns how long it takes from the given time until the transfer is done.
+double HMB_FTL::occupy_host_link(double time, long num_bytes) {
+	double start_time = max(time, host_link_free_time);
+	host_link_free_time = start_time + num_bytes / PCIE_BANDWIDTH;
+	return host_link_free_time - time;
+}
+
+// The SRAM is LRU, and its size in entries is given by the SRAM knob
+void HMB_FTL::insert_in_sram(long logical_address) {
+	long capacity = SRAM / MAPPING_ENTRY_SIZE;
+	if (capacity <= 0) {
+		return;
+	}
+	if (sram_entry_positions.count(logical_address) == 1) {
+		sram_entries.erase(sram_entry_positions[logical_address]);
+	}
+	sram_entries.push_front(logical_address);
+	sram_entry_positions[logical_address] = sram_entries.begin();
+	if ((long)sram_entries.size() > capacity) {
+		sram_entry_positions.erase(sram_entries.back());
+		sram_entries.pop_back();
+	}
+}
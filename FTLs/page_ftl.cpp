@@ -25,9 +25,74 @@
 
 using namespace ssd;
 
+bool FtlImpl_Page::USE_EXTENT_MAPPING = false;
+
+// =================  Extent_Map  =============================
+
+long Extent_Map::get(ulong logical_address) const {
+	auto extent = extents.upper_bound(logical_address);
+	if (extent == extents.begin()) {
+		return UNDEFINED;
+	}
+	--extent;
+	ulong offset = logical_address - extent->first;
+	return offset < extent->second.length ? extent->second.physical_address + offset : UNDEFINED;
+}
+
+// Mapping to UNDEFINED removes the address from the map
+void Extent_Map::set(ulong logical_address, long physical_address) {
+	if (get(logical_address) == physical_address) {
+		return;
+	}
+	erase(logical_address);
+	if (physical_address == UNDEFINED) {
+		return;
+	}
+	auto extent = extents.emplace(logical_address, Extent(1, physical_address)).first;
+	auto next = std::next(extent);
+	if (next != extents.end() && next->first == logical_address + 1 && next->second.physical_address == physical_address + 1) {
+		extent->second.length += next->second.length;
+		extents.erase(next);
+	}
+	if (extent != extents.begin()) {
+		auto previous = std::prev(extent);
+		if (previous->first + previous->second.length == logical_address &&
+				previous->second.physical_address + (long)previous->second.length == physical_address) {
+			previous->second.length += extent->second.length;
+			extents.erase(extent);
+		}
+	}
+}
+
+// Cuts the address out of its extent, leaving the parts before and after it as separate extents
+void Extent_Map::erase(ulong logical_address) {
+	auto extent = extents.upper_bound(logical_address);
+	if (extent == extents.begin()) {
+		return;
+	}
+	--extent;
+	Extent old = extent->second;
+	ulong offset = logical_address - extent->first;
+	if (offset >= old.length) {
+		return;
+	}
+	if (offset == 0) {
+		extent = extents.erase(extent);
+	} else {
+		extent->second.length = offset;
+		++extent;
+	}
+	if (offset + 1 < old.length) {
+		extents.emplace_hint(extent, logical_address + 1, Extent(old.length - offset - 1, old.physical_address + offset + 1));
+	}
+}
+
+// =================  FtlImpl_Page  =============================
+
 FtlImpl_Page::FtlImpl_Page(Ssd *ssd, Block_manager_parent* bm):
 	FtlParent(ssd, bm),
 	logical_to_physical_map(NUMBER_OF_ADDRESSABLE_PAGES() + 1, UNDEFINED),
+	logical_to_physical_extents(),
 	physical_to_logical_map(NUMBER_OF_ADDRESSABLE_PAGES() + 1, UNDEFINED)
 {
 	IS_FTL_PAGE_MAPPING = true;
@@ -36,6 +101,7 @@ FtlImpl_Page::FtlImpl_Page(Ssd *ssd, Block_manager_parent* bm):
 FtlImpl_Page::FtlImpl_Page() :
 	FtlParent(),
 	logical_to_physical_map(NUMBER_OF_ADDRESSABLE_PAGES() + 1, UNDEFINED),
+	logical_to_physical_extents(),
 	physical_to_logical_map(NUMBER_OF_ADDRESSABLE_PAGES() + 1, UNDEFINED)
 {
 	IS_FTL_PAGE_MAPPING = true;
@@ -65,15 +131,15 @@ void FtlImpl_Page::register_write_completion(Event const& event, enum status res
 		return;
 	}
 
-	long new_phys_addr = event.get_address().get_linear_address();
+	long new_phys_addr = event.get_packed_address().get_linear_address();
 
 	long logi_addr = event.get_logical_address();
-	logical_to_physical_map[logi_addr] = new_phys_addr;
-	physical_to_logical_map[new_phys_addr] = logi_addr;
+	set_physical_address(logi_addr, new_phys_addr);
+	physical_to_logical_map.set(new_phys_addr, logi_addr);
 
-	if (event.get_replace_address().valid == PAGE) {
-		long old_phys_addr = event.get_replace_address().get_linear_address();
-		physical_to_logical_map[old_phys_addr] = UNDEFINED;
+	if (event.get_packed_replace_address().get_valid() == PAGE) {
+		long old_phys_addr = event.get_packed_replace_address().get_linear_address();
+		physical_to_logical_map.set(old_phys_addr, UNDEFINED);
 	}
 }
 
@@ -82,22 +148,38 @@ void FtlImpl_Page::register_read_completion(Event const& event, enum status resu
 }
 
 void FtlImpl_Page::register_trim_completion(Event & event) {
-	long phys_addr = event.get_replace_address().get_linear_address();
+	long phys_addr = event.get_packed_replace_address().get_linear_address();
 	long logi_addr = event.get_logical_address();
-	logical_to_physical_map[logi_addr] = UNDEFINED;
-	physical_to_logical_map[phys_addr] = UNDEFINED;
+	set_physical_address(logi_addr, UNDEFINED);
+	physical_to_logical_map.set(phys_addr, UNDEFINED);
 }
 
-long FtlImpl_Page::get_logical_address(uint physical_address) const {
+long FtlImpl_Page::get_logical_address(ulong physical_address) const {
 	return physical_to_logical_map[physical_address];
 }
 
-Address FtlImpl_Page::get_physical_address(uint logical_address) const {
-	assert(logical_address <= logical_to_physical_map.size());
-	long phys_addr = logical_to_physical_map[logical_address];
+Address FtlImpl_Page::get_physical_address(ulong logical_address) const {
+	assert(logical_address < logical_to_physical_map.size());
+	long phys_addr = USE_EXTENT_MAPPING ? logical_to_physical_extents.get(logical_address) : logical_to_physical_map[logical_address];
 	return phys_addr == UNDEFINED ? Address() : Address(phys_addr, PAGE);
 }
 
+void FtlImpl_Page::set_physical_address(ulong logical_address, long physical_address) {
+	if (USE_EXTENT_MAPPING) {
+		logical_to_physical_extents.set(logical_address, physical_address);
+	} else {
+		logical_to_physical_map.set(logical_address, physical_address);
+	}
+}
+
+void FtlImpl_Page::print() const {
+	if (USE_EXTENT_MAPPING) {
+		printf("Page FTL mapping extents:\t%lu\n", logical_to_physical_extents.get_num_extents());
+	} else {
+		printf("Page FTL mapping entries allocated:\t%lu\n", logical_to_physical_map.get_num_allocated_elements());
+	}
+}
+
 void FtlImpl_Page::set_replace_address(Event& event) const {
 	Address target = get_physical_address(event.get_logical_address());
 
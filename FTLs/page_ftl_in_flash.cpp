@@ -18,7 +18,7 @@ int ftl_cache::CACHED_ENTRIES_THRESHOLD = 10000;
 
 void ftl_cache::register_write_arrival(Event const& event)
 {
-	int la = event.get_logical_address();
+	long la = event.get_logical_address();
 	if (cached_mapping_table.count(la) == 1) {
 		entry& e = cached_mapping_table.at(la);
 		e.hotness++;
@@ -51,7 +51,7 @@ void ftl_cache::handle_read_dependency(Event* e) {
 }
 
 bool ftl_cache::register_read_arrival(Event* app_read) {
-	int la = app_read->get_logical_address();
+	long la = app_read->get_logical_address();
 	if (cached_mapping_table.count(la) == 1) {
 		ftl_cache::entry& e = cached_mapping_table.at(la);
 		e.hotness++;
@@ -122,11 +122,11 @@ void ftl_cache::clear_clean_entries(double time) {
 	while (cached_mapping_table.size() >= CACHED_ENTRIES_THRESHOLD && erase_victim(time, false) != UNDEFINED);
 }
 
-int ftl_cache::choose_dirty_victim(double time) {
+long ftl_cache::choose_dirty_victim(double time) {
 	return erase_victim(time, true);
 }
 
-bool ftl_cache::mark_clean(int key, double time) {
+bool ftl_cache::mark_clean(long key, double time) {
 	if (cached_mapping_table.count(key) == 0) {
 		return false;
 	}
@@ -142,11 +142,11 @@ bool ftl_cache::mark_clean(int key, double time) {
 	return was_dirty;
 }
 
-bool ftl_cache::contains(int key) const {
+bool ftl_cache::contains(long key) const {
 	return cached_mapping_table.count(key) == 1;
 }
 
-void ftl_cache::set_synchronized(int key) {
+void ftl_cache::set_synchronized(long key) {
 	if (cached_mapping_table.count(key) == 1) {
 		ftl_cache::entry& e = cached_mapping_table.at(key);
 		e.synch_flag = true;
@@ -154,11 +154,11 @@ void ftl_cache::set_synchronized(int key) {
 }
 
 void flash_resident_page_ftl::update_bitmap(vector<bool>& bitmap, Address block_addr) {
-	int block_id = block_addr.get_block_id();
+	long block_id = block_addr.get_block_id();
 	Block* block = ssd->get_package(block_addr.package)->get_die(block_addr.die)->get_plane(block_addr.plane)->get_block(block_addr.block);
 	for (int i = 0; i < BLOCK_SIZE; i++) {
-		int log_addr = page_mapping->get_logical_address(block_id * BLOCK_SIZE + i);
-		int orig_logical_addr = block->get_page(i).get_logical_addr();
+		long log_addr = page_mapping->get_logical_address(block_id * BLOCK_SIZE + i);
+		long orig_logical_addr = block->get_page(i).get_logical_addr();
 		if (log_addr == UNDEFINED && bitmap[i] == true) {
 			bitmap[i] = false;
 
@@ -169,7 +169,7 @@ void flash_resident_page_ftl::update_bitmap(vector<bool>& bitmap, Address block_
 		if (log_addr != UNDEFINED) {
 			bool bit = bitmap[i];
 			if (bit != true) {
-				printf("warning: address %d is still valid, yet the bit for it is false.   block id: %d  page offset: %d\n", log_addr, block_id, i);
+				printf("warning: address %ld is still valid, yet the bit for it is false.   block id: %ld  page offset: %d\n", log_addr, block_id, i);
 			}
 			assert(bit == true);
 		}
@@ -178,13 +178,13 @@ void flash_resident_page_ftl::update_bitmap(vector<bool>& bitmap, Address block_
 
 }
 
-void flash_resident_page_ftl::set_synchronized(int logical_address) {
+void flash_resident_page_ftl::set_synchronized(long logical_address) {
 	assert(cache->contains(logical_address));
 	cache->set_synchronized(logical_address);
 }
 
 // Uses a clock entry replacement policy
-int ftl_cache::erase_victim(double time, bool allow_flushing_dirty) {
+long ftl_cache::erase_victim(double time, bool allow_flushing_dirty) {
 	//printf("flush called. num dirty: %d     cache size: %d\n", get_num_dirty_entries(), cached_mapping_table.size());
 	// start at a given location
 	// find first entry with hotness 0 and make that the target, or make full traversal and identify least hot entry
@@ -0,0 +1,262 @@
+#include "../ssd.h"
+
+using namespace ssd;
+
+int ZNS_FTL::MAX_OPEN_ZONES = 14;
+
+ZNS_FTL::ZNS_FTL(Ssd *ssd, Block_manager_parent* bm, Migrator* migrator) :
+		FtlParent(ssd, bm),
+		migrator(migrator),
+		zones(get_num_zones()),
+		num_open_zones(0),
+		writes_waiting_for_open_zone(),
+		queued_writes(),
+		zone_stats()
+{
+	assert(MAX_OPEN_ZONES > 0);
+}
+
+ZNS_FTL::ZNS_FTL() :
+		FtlParent(),
+		migrator(),
+		zones(),
+		num_open_zones(0),
+		writes_waiting_for_open_zone(),
+		queued_writes(),
+		zone_stats()
+{}
+
+ZNS_FTL::~ZNS_FTL() {
+	print();
+}
+
+// The logical addresses past the last whole zone are not used. One block of each die is held by the free block pointers
+// of the block manager, so there is at most one zone for each of the other blocks of a die.
+long ZNS_FTL::get_num_zones() {
+	return min((long)NUMBER_OF_ADDRESSABLE_PAGES() / get_zone_size(), (long)DIE_SIZE * PLANE_SIZE - 1);
+}
+
+// Pages that have not been written since their zone was last reset hold no data, so reads of them are not sent to flash
+void ZNS_FTL::read(Event *event) {
+	if (get_physical_address(event->get_logical_address()).valid == NONE) {
+		event->set_noop(true);
+	}
+	scheduler->schedule_event(event);
+}
+
+void ZNS_FTL::write(Event *event) {
+	long zone_id = event->get_logical_address() / get_zone_size();
+	if (zone_id >= (long)zones.size()) {
+		fprintf(stderr, "Error: logical address %lu is past the last zone. There are %lu zones of %ld pages.\n", event->get_logical_address(), zones.size(), get_zone_size());
+		assert(false);
+	}
+	zone& z = zones[zone_id];
+	if (z.state == ZONE_FULL) {
+		fprintf(stderr, "Error: the zone of logical address %lu is full. It must be reset before it is written again.\n", event->get_logical_address());
+		assert(false);
+	}
+	if (z.state == ZONE_EMPTY && !open_zone(z, event->get_current_time())) {
+		writes_waiting_for_open_zone.push(event);
+		zone_stats.num_writes_waiting_for_open_zone++;
+		return;
+	}
+	if (event->get_zone_command() == ZONE_APPEND) {
+		event->set_logical_address(zone_id * get_zone_size() + z.write_pointer);
+		zone_stats.num_appends++;
+	}
+	long offset = event->get_logical_address() % get_zone_size();
+	if (offset < z.write_pointer) {
+		fprintf(stderr, "Error: logical address %lu is behind the write pointer of its zone, which is at offset %ld. Zones must be written sequentially.\n", event->get_logical_address(), z.write_pointer);
+		assert(false);
+	}
+	if (offset > z.write_pointer) {
+		assert(z.waiting_writes.count(offset) == 0);
+		z.waiting_writes[offset] = event;
+		return;
+	}
+	place(event, z);
+	while (z.state == ZONE_OPEN && z.waiting_writes.count(z.write_pointer) == 1) {
+		Event* next = z.waiting_writes[z.write_pointer];
+		z.waiting_writes.erase(z.write_pointer);
+		next->incr_bus_wait_time(max(event->get_current_time() - next->get_current_time(), 0.0));
+		place(next, z);
+	}
+}
+
+// Zone resets and finishes take effect when they arrive, so they are not sent to flash. The erases of a reset are scheduled
+// on their own. Plain trims have no effect, since the host discards data a zone at a time.
+void ZNS_FTL::trim(Event *event) {
+	long zone_id = event->get_logical_address() / get_zone_size();
+	if (zone_id < (long)zones.size() && event->get_zone_command() == ZONE_RESET) {
+		reset_zone(zones[zone_id], event->get_current_time());
+		zone_stats.num_resets++;
+	} else if (zone_id < (long)zones.size() && event->get_zone_command() == ZONE_FINISH) {
+		zone& z = zones[zone_id];
+		if (!z.waiting_writes.empty()) {
+			fprintf(stderr, "Error: zone %ld is finished while %lu writes wait for the writes before them.\n", zone_id, z.waiting_writes.size());
+			assert(false);
+		}
+		if (z.state == ZONE_OPEN) {
+			close_zone(z, event->get_current_time());
+		}
+		z.state = ZONE_FULL;
+		zone_stats.num_finishes++;
+	}
+	event->set_noop(true);
+	scheduler->schedule_event(event);
+}
+
+// The next write to the block can be scheduled once the previous one has been written
+void ZNS_FTL::register_write_completion(Event const& event, enum status result) {
+	collect_stats(event);
+	long block_id = event.get_address().get_block_id();
+	queue<Event*>& waiting = queued_writes.at(block_id);
+	if (waiting.empty()) {
+		queued_writes.erase(block_id);
+		return;
+	}
+	Event* next = waiting.front();
+	waiting.pop();
+	next->incr_bus_wait_time(max(event.get_current_time() - next->get_current_time(), 0.0));
+	scheduler->schedule_event(next);
+}
+
+void ZNS_FTL::register_read_completion(Event const& event, enum status result) {
+	collect_stats(event);
+}
+
+void ZNS_FTL::register_trim_completion(Event & event) {}
+
+long ZNS_FTL::get_logical_address(ulong physical_address) const {
+	Address a = Address(physical_address, PAGE);
+	return ssd->get_package(a.package)->get_die(a.die)->get_plane(a.plane)->get_block(a.block)->get_page(a.page).get_logical_addr();
+}
+
+// Page o of a zone is page o / N of the block of die o % N in its superblock, where N is the number of dies
+Address ZNS_FTL::get_physical_address(ulong logical_address) const {
+	long zone_id = logical_address / get_zone_size();
+	long offset = logical_address % get_zone_size();
+	if (zone_id >= (long)zones.size() || offset >= zones[zone_id].write_pointer) {
+		return Address();
+	}
+	int num_dies = SSD_SIZE * PACKAGE_SIZE;
+	Address address = zones[zone_id].superblock[offset % num_dies];
+	address.page = offset / num_dies;
+	address.valid = PAGE;
+	return address;
+}
+
+// Pages are never overwritten, so no write or trim replaces a page
+void ZNS_FTL::set_replace_address(Event& event) const {}
+
+void ZNS_FTL::set_read_address(Event& event) const {
+	Address target = get_physical_address(event.get_logical_address());
+	assert(target.valid == PAGE);
+	event.set_address(target);
+}
+
+void ZNS_FTL::register_erase_completion(Event & event) {
+	if (!writes_waiting_for_open_zone.empty()) {
+		release_writes_waiting_for_open_zone(event.get_current_time());
+	}
+}
+
+// Takes a free block from every die. If a die has none left, the blocks taken so far are given back and the zone stays empty.
+bool ZNS_FTL::open_zone(zone& z, double time) {
+	if (num_open_zones >= MAX_OPEN_ZONES) {
+		return false;
+	}
+	vector<Address> superblock;
+	superblock.reserve(SSD_SIZE * PACKAGE_SIZE);
+	for (uint package = 0; package < SSD_SIZE; package++) {
+		for (uint die = 0; die < PACKAGE_SIZE; die++) {
+			Address block = bm->find_free_unused_block(package, die, time);
+			if (block.valid == NONE) {
+				for (auto taken : superblock) {
+					bm->return_unfilled_block(taken, time, false);
+				}
+				return false;
+			}
+			superblock.push_back(block);
+		}
+	}
+	z.superblock = superblock;
+	z.state = ZONE_OPEN;
+	num_open_zones++;
+	return true;
+}
+
+void ZNS_FTL::close_zone(zone& z, double time) {
+	z.state = ZONE_FULL;
+	num_open_zones--;
+	release_writes_waiting_for_open_zone(time);
+}
+
+// The blocks that have been written to are erased, and the others are given back to the block manager.
+// The host must wait for the writes to the zone to finish before resetting it.
+void ZNS_FTL::reset_zone(zone& z, double time) {
+	if (!z.waiting_writes.empty()) {
+		fprintf(stderr, "Error: a zone is reset while %lu writes wait for the writes before them.\n", z.waiting_writes.size());
+		assert(false);
+	}
+	for (uint i = 0; i < z.superblock.size(); i++) {
+		Address const& block = z.superblock[i];
+		if (queued_writes.count(block.get_block_id()) == 1) {
+			fprintf(stderr, "Error: a zone is reset while writes to it are in progress.\n");
+			assert(false);
+		}
+		if (z.write_pointer > (long)i) {
+			migrator->erase_block(block, time);
+		} else {
+			bm->return_unfilled_block(block, time, false);
+		}
+	}
+	bool was_open = z.state == ZONE_OPEN;
+	z = zone();
+	if (was_open) {
+		num_open_zones--;
+		release_writes_waiting_for_open_zone(time);
+	}
+}
+
+void ZNS_FTL::place(Event* event, zone& z) {
+	int num_dies = SSD_SIZE * PACKAGE_SIZE;
+	Address address = z.superblock[z.write_pointer % num_dies];
+	address.page = z.write_pointer / num_dies;
+	address.valid = PAGE;
+	event->set_address(address);
+	z.write_pointer++;
+	schedule_write(event);
+	if (z.write_pointer == get_zone_size()) {
+		close_zone(z, event->get_current_time());
+	}
+}
+
+void ZNS_FTL::schedule_write(Event* event) {
+	long block_id = event->get_address().get_block_id();
+	if (queued_writes.count(block_id) == 0) {
+		queued_writes[block_id] = queue<Event*>();
+		scheduler->schedule_event(event);
+	} else {
+		queued_writes[block_id].push(event);
+	}
+}
+
+// The writes are retried in the order in which they arrived. Those that still cannot open their zone wait again.
+void ZNS_FTL::release_writes_waiting_for_open_zone(double time) {
+	queue<Event*> waiting;
+	swap(waiting, writes_waiting_for_open_zone);
+	while (!waiting.empty()) {
+		Event* event = waiting.front();
+		waiting.pop();
+		event->incr_bus_wait_time(max(time - event->get_current_time(), 0.0));
+		write(event);
+	}
+}
+
+void ZNS_FTL::print() const {
+	printf("ZNS zone appends\t%ld\n", zone_stats.num_appends);
+	printf("ZNS zone resets\t%ld\n", zone_stats.num_resets);
+	printf("ZNS zone finishes\t%ld\n", zone_stats.num_finishes);
+	printf("ZNS writes that waited for a zone to open\t%ld\n", zone_stats.num_writes_waiting_for_open_zone);
+}
@@ -8,21 +8,105 @@
 #include "../ssd.h"
 using namespace ssd;
 
-int FIFO_OS_Scheduler::pick(unordered_map<int, Thread*> const& threads) {
-	long double soonest_event_time = std::numeric_limits<long double>::max();
-	int thread_id_with_soonest_event = UNDEFINED;
-	for (auto i : threads) {
-		int id = i.first;
-		Thread* t = i.second;
-		Event* e = t->peek();
-		if (e != NULL && e->get_current_time() < soonest_event_time) {
-			soonest_event_time = e->get_current_time();
-			thread_id_with_soonest_event = id;
+// =================  Thread_Priority_Queue  =============================
+
+void Thread_Priority_Queue::update(int thread_id, double key) {
+	if (contains(thread_id)) {
+		uint index = positions[thread_id];
+		double old_key = heap[index].first;
+		heap[index].first = key;
+		if (key < old_key) {
+			sift_up(index);
+		} else {
+			sift_down(index);
+		}
+	} else {
+		heap.push_back(pair<double, int>(key, thread_id));
+		positions[thread_id] = heap.size() - 1;
+		sift_up(heap.size() - 1);
+	}
+}
+
+void Thread_Priority_Queue::remove(int thread_id) {
+	if (!contains(thread_id)) {
+		return;
+	}
+	uint index = positions[thread_id];
+	uint last = heap.size() - 1;
+	if (index != last) {
+		swap_nodes(index, last);
+	}
+	heap.pop_back();
+	positions.erase(thread_id);
+	if (index < heap.size()) {
+		sift_up(index);
+		sift_down(index);
+	}
+}
+
+void Thread_Priority_Queue::clear() {
+	heap.clear();
+	positions.clear();
+}
+
+void Thread_Priority_Queue::sift_up(uint index) {
+	while (index > 0) {
+		uint parent = (index - 1) / 2;
+		if (heap[index] < heap[parent]) {
+			swap_nodes(index, parent);
+			index = parent;
+		} else {
+			return;
 		}
 	}
-	return thread_id_with_soonest_event;
 }
 
+void Thread_Priority_Queue::sift_down(uint index) {
+	while (true) {
+		uint left = 2 * index + 1;
+		uint right = left + 1;
+		uint smallest = index;
+		if (left < heap.size() && heap[left] < heap[smallest]) {
+			smallest = left;
+		}
+		if (right < heap.size() && heap[right] < heap[smallest]) {
+			smallest = right;
+		}
+		if (smallest == index) {
+			return;
+		}
+		swap_nodes(index, smallest);
+		index = smallest;
+	}
+}
+
+void Thread_Priority_Queue::swap_nodes(uint a, uint b) {
+	swap(heap[a], heap[b]);
+	positions[heap[a].second] = a;
+	positions[heap[b].second] = b;
+}
+
+// =================  FIFO_OS_Scheduler  =============================
+
+int FIFO_OS_Scheduler::pick(unordered_map<int, Thread*> const& threads) {
+	return next_io_times.empty() ? UNDEFINED : next_io_times.top();
+}
+
+void FIFO_OS_Scheduler::register_thread_update(int thread_id, Thread* thread) {
+	Event* e = thread->peek();
+	if (e == NULL) {
+		next_io_times.remove(thread_id);
+	} else {
+		next_io_times.update(thread_id, e->get_current_time());
+	}
+}
+
+void FIFO_OS_Scheduler::register_thread_removal(int thread_id) {
+	next_io_times.remove(thread_id);
+}
+
+// =================  FAIR_OS_Scheduler  =============================
+
 int FAIR_OS_Scheduler::pick(unordered_map<int, Thread*> const& threads) {
 
 	for (auto entry : threads)
@@ -53,3 +137,65 @@ int FAIR_OS_Scheduler::pick(unordered_map<int, Thread*> const& threads) {
 	//printf("%d\n", last_id);
 	return !found ? UNDEFINED : last_id;
 }
+
+// =================  Weighted_Fair_OS_Scheduler  =============================
+
+// Only IOs that have arrived by the current time are eligible, or the earliest IO to arrive if none has.
+// This prevents dispatching IOs from the future ahead of IOs that arrive earlier.
+int Weighted_Fair_OS_Scheduler::pick(unordered_map<int, Thread*> const& threads) {
+	if (arrival_times.empty() && virtual_start_tags.empty()) {
+		return UNDEFINED;
+	}
+	double horizon = time;
+	if (virtual_start_tags.empty()) {
+		horizon = max(horizon, arrival_times.top_key());
+	}
+	while (!arrival_times.empty() && arrival_times.top_key() <= horizon) {
+		int thread_id = arrival_times.top();
+		make_eligible(thread_id, threads.at(thread_id));
+	}
+	if (!deadlines.empty() && deadlines.top_key() <= horizon) {
+		return deadlines.top();
+	}
+	return virtual_start_tags.top();
+}
+
+// A thread that was idle cannot claim the share it did not use while idle, so its start tag is at least the virtual time
+void Weighted_Fair_OS_Scheduler::make_eligible(int thread_id, Thread* thread) {
+	double arrival_time = arrival_times.get_key(thread_id);
+	arrival_times.remove(thread_id);
+	double start_tag = virtual_time;
+	if (virtual_finish_tags.count(thread_id) == 1) {
+		start_tag = max(start_tag, virtual_finish_tags[thread_id]);
+	}
+	virtual_start_tags.update(thread_id, start_tag);
+	if (thread->get_latency_target() > 0) {
+		deadlines.update(thread_id, arrival_time + thread->get_latency_target());
+	}
+}
+
+void Weighted_Fair_OS_Scheduler::register_dispatch(int thread_id, Thread* thread, Event const& event) {
+	assert(virtual_start_tags.contains(thread_id));
+	double start_tag = virtual_start_tags.get_key(thread_id);
+	int weight = max(thread->get_io_weight(), 1);
+	virtual_time = max(virtual_time, start_tag);
+	virtual_finish_tags[thread_id] = start_tag + event.get_size() * (double) DEFAULT_IO_WEIGHT / weight;
+}
+
+void Weighted_Fair_OS_Scheduler::register_thread_update(int thread_id, Thread* thread) {
+	virtual_start_tags.remove(thread_id);
+	deadlines.remove(thread_id);
+	Event* e = thread->peek();
+	if (e == NULL) {
+		arrival_times.remove(thread_id);
+	} else {
+		arrival_times.update(thread_id, e->get_current_time());
+	}
+}
+
+void Weighted_Fair_OS_Scheduler::register_thread_removal(int thread_id) {
+	arrival_times.remove(thread_id);
+	virtual_start_tags.remove(thread_id);
+	deadlines.remove(thread_id);
+	virtual_finish_tags.erase(thread_id);
+}
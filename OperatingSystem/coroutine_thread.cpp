@@ -0,0 +1,108 @@
+/*
+ * coroutine_thread.cpp
+ *
+ *  Threads whose clients are written as C++20 coroutines.
+ */
+
+#include "../ssd.h"
+using namespace ssd;
+
+// =================  Coroutine_Thread  =============================
+
+Coroutine_Thread::Coroutine_Thread(int num_clients)
+	: Thread(),
+	  num_clients(num_clients),
+	  clients(),
+	  waiting_clients()
+{
+	assert(num_clients > 0);
+}
+
+Coroutine_Thread::~Coroutine_Thread() {
+	for (auto client : clients) {
+		client.destroy();
+	}
+}
+
+// Each client runs until it awaits its first IOs
+void Coroutine_Thread::issue_first_IOs() {
+	clients.reserve(num_clients);
+	for (int i = 0; i < num_clients; i++) {
+		clients.push_back(run_client(i).handle);
+	}
+	for (auto client : clients) {
+		client.resume();
+	}
+}
+
+// The client that awaits the IO is resumed once the last of the IOs it awaits has completed.
+// It runs until it awaits its next IOs or returns.
+void Coroutine_Thread::handle_event_completion(Event* event) {
+	auto waiting_client = waiting_clients.find(event->get_application_io_id());
+	assert(waiting_client != waiting_clients.end());
+	coroutine_handle<Client::promise_type> client = waiting_client->second;
+	waiting_clients.erase(waiting_client);
+	client.promise().last_completed_lba = event->get_logical_address();
+	if (--client.promise().num_pending_ios == 0) {
+		client.resume();
+	}
+}
+
+// The waiting clients are resumed in the order in which they started waiting. A client that waits for the condition again
+// while the others are being resumed waits for the next notification.
+void Coroutine_Thread::notify(Condition& condition) {
+	vector<coroutine_handle<Client::promise_type> > waiting_clients;
+	swap(waiting_clients, condition.waiting_clients);
+	for (auto client : waiting_clients) {
+		client.resume();
+	}
+}
+
+// One IO is created per page, so that IOs to different pages can execute in parallel in the SSD.
+// Like in the File_Manager, tagged writes carry the size of the whole range as a hint.
+Coroutine_Thread::IO_Awaiter Coroutine_Thread::create_awaiter(event_type type, Address_Range range, int tag, double start_time) {
+	bool is_tagged = tag != UNDEFINED && ENABLE_TAGGING;
+	double time = max(get_current_time(), start_time);
+	vector<Event*> events;
+	events.reserve(range.get_size());
+	for (long lba = range.min; lba <= range.max; lba++) {
+		Event* event = new Event(type, lba, is_tagged ? range.get_size() : 1, time);
+		if (is_tagged) {
+			event->set_tag(tag);
+		}
+		events.push_back(event);
+	}
+	return IO_Awaiter(this, events);
+}
+
+Coroutine_Thread::IO_Awaiter Coroutine_Thread::create_zone_command(event_type type, zone_command command, long zone_lba) {
+	Event* event = new Event(type, zone_lba, 1, get_current_time());
+	event->set_zone_command(command);
+	return IO_Awaiter(this, vector<Event*>(1, event));
+}
+
+void Coroutine_Thread::IO_Awaiter::await_suspend(coroutine_handle<Client::promise_type> client) {
+	this->client = client;
+	client.promise().num_pending_ios = events.size();
+	for (auto event : events) {
+		thread->waiting_clients[event->get_application_io_id()] = client;
+		thread->submit(event);
+	}
+}
+
+// =================  Random_Read_Modify_Write_Clients  =============================
+
+Random_Read_Modify_Write_Clients::Random_Read_Modify_Write_Clients(long min_LBA, long max_LBA, int num_clients, ulong randseed)
+	: Coroutine_Thread(num_clients),
+	  min_LBA(min_LBA),
+	  max_LBA(max_LBA),
+	  random_number_generator(randseed)
+{}
+
+Coroutine_Thread::Client Random_Read_Modify_Write_Clients::run_client(int client_id) {
+	while (true) {
+		long lba = min_LBA + random_number_generator.below(max_LBA - min_LBA + 1);
+		co_await read(lba);
+		co_await write(lba);
+	}
+}
@@ -0,0 +1,169 @@
+/*
+ * fio_thread.cpp
+ *
+ *  Threads that run the jobs of fio job files, and the statistics they report in fio's JSON format.
+ */
+
+#include "../ssd.h"
+using namespace ssd;
+
+// =================  Fio_Thread  =============================
+
+Fio_Thread::Fio_Thread(IO_Pattern* block_pattern, IO_Mode_Generator* type_generator, long first_LBA, int block_size, int iodepth,
+		long num_IOs, double runtime, double rate_iops, Fio_Job_Statistics* statistics)
+	: Thread(),
+	  block_pattern(block_pattern),
+	  type_generator(type_generator),
+	  first_LBA(first_LBA),
+	  block_size(block_size),
+	  iodepth(iodepth),
+	  num_IOs_left(num_IOs),
+	  end_time(runtime),
+	  rate_iops(rate_iops),
+	  next_io_time(0),
+	  next_io_id(0),
+	  ongoing_IOs(),
+	  io_of_page(),
+	  statistics(statistics)
+{
+	assert(block_size > 0 && iodepth > 0);
+}
+
+Fio_Thread::~Fio_Thread() {
+	delete block_pattern;
+	delete type_generator;
+}
+
+// The runtime counts from when the job starts
+void Fio_Thread::issue_first_IOs() {
+	if (end_time != UNDEFINED) {
+		end_time += get_current_time();
+	}
+	generate_io();
+}
+
+void Fio_Thread::handle_event_completion(Event* event) {
+	unordered_map<uint, int>::iterator page = io_of_page.find(event->get_application_io_id());
+	assert(page != io_of_page.end());
+	Fio_IO& io = ongoing_IOs[page->second];
+	io.submission_time = min(io.submission_time, event->get_ssd_submission_time());
+	if (--io.num_pages_left == 0) {
+		statistics->register_io(io.type, block_size, io.start_time, io.submission_time, event->get_current_time());
+		ongoing_IOs.erase(page->second);
+	}
+	io_of_page.erase(page);
+	generate_io();
+}
+
+void Fio_Thread::generate_io() {
+	while ((int)ongoing_IOs.size() < iodepth && num_IOs_left > 0 && !is_finished() && !is_stopped()) {
+		double time = rate_iops == UNDEFINED ? get_current_time() : max(get_current_time(), next_io_time);
+		if (end_time != UNDEFINED && time >= end_time) {
+			return;
+		}
+		if (rate_iops != UNDEFINED) {
+			next_io_time = time + 1000000.0 / rate_iops;
+		}
+		num_IOs_left--;
+		Fio_IO& io = ongoing_IOs[next_io_id];
+		io.type = type_generator->next();
+		io.num_pages_left = block_size;
+		io.start_time = time;
+		io.submission_time = numeric_limits<double>::infinity();
+		long first_page = first_LBA + (long)block_pattern->next() * block_size;
+		for (int i = 0; i < block_size; i++) {
+			Event* event = new Event(io.type, first_page + i, 1, time);
+			io_of_page[event->get_application_io_id()] = next_io_id;
+			submit(event);
+		}
+		next_io_id++;
+	}
+}
+
+// =================  Fio_Job_Statistics  =============================
+
+Fio_Job_Statistics::Fio_Job_Statistics(string name)
+	: name(name),
+	  reads(),
+	  writes(),
+	  trims(),
+	  start_time(numeric_limits<double>::infinity()),
+	  end_time(0)
+{}
+
+void Fio_Job_Statistics::register_io(event_type type, int num_pages, double io_start_time, double submission_time, double completion_time) {
+	Direction& direction = type == READ ? reads : type == WRITE ? writes : trims;
+	direction.num_IOs++;
+	direction.num_pages += num_pages;
+	direction.completion_latencies.push_back(completion_time - submission_time);
+	direction.total_latencies.push_back(completion_time - io_start_time);
+	start_time = min(start_time, io_start_time);
+	end_time = max(end_time, completion_time);
+}
+
+// Simulated time is in microseconds, while fio reports runtimes in milliseconds and latencies in nanoseconds
+void Fio_Job_Statistics::print_json(FILE* stream, map<string, string> const& options) const {
+	double runtime = end_time > start_time ? end_time - start_time : 0;
+	fprintf(stream, "    {\n");
+	fprintf(stream, "      \"jobname\" : \"%s\",\n", name.c_str());
+	fprintf(stream, "      \"groupid\" : 0,\n");
+	fprintf(stream, "      \"error\" : 0,\n");
+	fprintf(stream, "      \"job options\" : {\n");
+	for (map<string, string>::const_iterator option = options.begin(); option != options.end(); option++) {
+		fprintf(stream, "        \"%s\" : \"%s\"%s\n", option->first.c_str(), option->second.c_str(), next(option) == options.end() ? "" : ",");
+	}
+	fprintf(stream, "      },\n");
+	print_direction_json(stream, "read", reads);
+	print_direction_json(stream, "write", writes);
+	print_direction_json(stream, "trim", trims);
+	fprintf(stream, "      \"job_runtime\" : %ld\n", (long)(runtime / 1000));
+	fprintf(stream, "    }");
+}
+
+void Fio_Job_Statistics::print_direction_json(FILE* stream, string direction_name, Direction const& direction) const {
+	double runtime = end_time > start_time ? end_time - start_time : 0;
+	long bytes = direction.num_pages * PAGE_SIZE;
+	double bandwidth = runtime > 0 ? bytes / (runtime / 1000000) : 0;  // bytes per second
+	double iops = runtime > 0 ? direction.num_IOs / (runtime / 1000000) : 0;
+	fprintf(stream, "      \"%s\" : {\n", direction_name.c_str());
+	fprintf(stream, "        \"io_bytes\" : %ld,\n", bytes);
+	fprintf(stream, "        \"io_kbytes\" : %ld,\n", bytes / 1024);
+	fprintf(stream, "        \"bw_bytes\" : %ld,\n", (long)bandwidth);
+	fprintf(stream, "        \"bw\" : %ld,\n", (long)(bandwidth / 1024));
+	fprintf(stream, "        \"iops\" : %f,\n", iops);
+	fprintf(stream, "        \"runtime\" : %ld,\n", (long)(runtime / 1000));
+	fprintf(stream, "        \"total_ios\" : %ld,\n", direction.num_IOs);
+	print_latency_json(stream, "clat_ns", direction.completion_latencies, true, false);
+	print_latency_json(stream, "lat_ns", direction.total_latencies, false, true);
+	fprintf(stream, "      },\n");
+}
+
+// Percentiles are picked by nearest rank, at the same points as fio's default percentile_list
+void Fio_Job_Statistics::print_latency_json(FILE* stream, string name, vector<double> latencies, bool print_percentiles, bool is_last) {
+	static const double percentiles[] = {1, 5, 10, 20, 30, 40, 50, 60, 70, 80, 90, 95, 99, 99.5, 99.9, 99.95, 99.99};
+	sort(latencies.begin(), latencies.end());
+	double sum = 0, sum_of_squares = 0;
+	for (auto latency : latencies) {
+		sum += latency * 1000;
+		sum_of_squares += latency * 1000 * latency * 1000;
+	}
+	double mean = latencies.empty() ? 0 : sum / latencies.size();
+	double stddev = latencies.size() < 2 ? 0 : sqrt(max(0.0, (sum_of_squares - sum * mean) / (latencies.size() - 1)));
+	fprintf(stream, "        \"%s\" : {\n", name.c_str());
+	fprintf(stream, "          \"min\" : %ld,\n", latencies.empty() ? 0 : (long)(latencies.front() * 1000));
+	fprintf(stream, "          \"max\" : %ld,\n", latencies.empty() ? 0 : (long)(latencies.back() * 1000));
+	fprintf(stream, "          \"mean\" : %f,\n", mean);
+	fprintf(stream, "          \"stddev\" : %f,\n", stddev);
+	fprintf(stream, "          \"N\" : %zu%s\n", latencies.size(), print_percentiles && !latencies.empty() ? "," : "");
+	if (print_percentiles && !latencies.empty()) {
+		int num_percentiles = sizeof(percentiles) / sizeof(percentiles[0]);
+		fprintf(stream, "          \"percentile\" : {\n");
+		for (int i = 0; i < num_percentiles; i++) {
+			long rank = (long)ceil(percentiles[i] / 100 * latencies.size());
+			double latency = latencies[min((long)latencies.size(), max(rank, 1L)) - 1];
+			fprintf(stream, "            \"%f\" : %ld%s\n", percentiles[i], (long)(latency * 1000), i == num_percentiles - 1 ? "" : ",");
+		}
+		fprintf(stream, "          }\n");
+	}
+	fprintf(stream, "        }%s\n", is_last ? "" : ",");
+}
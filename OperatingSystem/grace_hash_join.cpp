@@ -53,9 +53,9 @@ Grace_Hash_Join::Grace_Hash_Join
 
 	output_buffers.resize(num_partitions, 0);
 	for (int i = 0; i < num_partitions; i++) {
-		output_cursors.push_back(free_space_min_LBA + (int) (free_space_size * ((double) i / (num_partitions + 1))));
+		output_cursors.push_back(free_space_min_LBA + (long) (free_space_size * ((double) i / (num_partitions + 1))));
 	}
-	output_cursors_startpoints = vector<int>(output_cursors);
+	output_cursors_startpoints = vector<long>(output_cursors);
 }
 
 void Grace_Hash_Join::create_flexible_reader(int start, int finish) {
@@ -125,7 +125,7 @@ void Grace_Hash_Join::execute_build_phase() {
 		if (PRINT_LEVEL >= 1) printf("Grace Hash Join, build phase: Switching to relation 2\n");
 		input_cursor = relation_B_min_LBA;
 		//VisualTracer::get_instance()->print_horizontally(6000);
-		output_cursors_splitpoints = vector<int>(output_cursors);
+		output_cursors_splitpoints = vector<long>(output_cursors);
 		if (use_flexible_reads) {
 			assert(flex_reader->is_finished());
 			create_flexible_reader(relation_B_min_LBA, relation_B_max_LBA);
@@ -169,7 +169,7 @@ void Grace_Hash_Join::handle_read_completion_build() {
 void Grace_Hash_Join::flush_buffer(int buffer_id) {
 	bool at_relation_A = (input_cursor >= relation_A_min_LBA && input_cursor <= relation_A_max_LBA);
 	int estimated_tag_size = 1;// at_relation_A ? relation_A_size / num_partitions : relation_B_size / num_partitions;
-	int lba = output_cursors[buffer_id]++;
+	long lba = output_cursors[buffer_id]++;
 	Event* write = new Event(WRITE, lba, estimated_tag_size, get_current_time());
 	//if (use_tagging) write->set_tag(buffer_id * 2 + at_relation_A);
 	//if (use_tagging) write->set_tag(1234);
@@ -0,0 +1,273 @@
+/*
+ * lsm_tree.cpp
+ *
+ *  The IO pattern of a key-value store based on a log-structured merge tree.
+ */
+
+#include "../ssd.h"
+using namespace ssd;
+
+const double LSM_Tree::DATASET_FRACTION = 0.5;
+
+LSM_Tree::LSM_Tree(long min_LBA, long max_LBA, int file_size, int level_fanout, double write_rate, int num_compaction_clients)
+	: Coroutine_Thread(2 + num_compaction_clients),
+	  min_LBA(min_LBA),
+	  max_LBA(max_LBA),
+	  first_file_LBA(min_LBA + (MAX_IMMUTABLE_MEMTABLES + 1) * file_size),
+	  file_size(file_size),
+	  level_fanout(level_fanout),
+	  write_rate(write_rate),
+	  next_write_time(0),
+	  log_size((MAX_IMMUTABLE_MEMTABLES + 1) * file_size),
+	  log_cursor(0),
+	  num_memtable_pages(0),
+	  num_immutable_memtables(0),
+	  num_flushed_memtables(0),
+	  dataset_size(0),
+	  levels(),
+	  compaction_cursors(),
+	  free_slots(),
+	  files(),
+	  file_id_generator(LOG_TAG + 1),
+	  memtable_full(),
+	  writes_can_resume(),
+	  compaction_possible(),
+	  slot_freed()
+{
+	assert(file_size > 0 && level_fanout > 1 && num_compaction_clients > 0);
+	long num_slots = (max_LBA - first_file_LBA + 1) / file_size;
+	assert(num_slots > 4 * LEVEL_0_STOP_WRITES_TRIGGER);
+	for (long slot = 0; slot < num_slots; slot++) {
+		free_slots.insert(free_slots.end(), slot);
+	}
+	dataset_size = num_slots * file_size * DATASET_FRACTION;
+	// The last level is the first one whose target size can hold the dataset
+	int num_levels = 2;
+	while (get_target_size(num_levels - 1) < dataset_size) {
+		num_levels++;
+	}
+	levels.resize(num_levels);
+	compaction_cursors.resize(num_levels, 0);
+}
+
+LSM_Tree::~LSM_Tree() {
+	for (auto file : files) {
+		delete file.second;
+	}
+}
+
+Coroutine_Thread::Client LSM_Tree::run_client(int client_id) {
+	if (client_id == 0) {
+		return write_log();
+	} else if (client_id == 1) {
+		return flush_memtables();
+	}
+	return compact();
+}
+
+// Writes stall while the immutable memtables wait to be flushed, or while level 0 has too many files
+Coroutine_Thread::Client LSM_Tree::write_log() {
+	while (true) {
+		if (!can_write()) {
+			co_await wait(writes_can_resume);
+			continue;
+		}
+		double start_time = UNDEFINED;
+		if (write_rate > 0) {
+			start_time = max(get_current_time(), next_write_time);
+			next_write_time = start_time + 1000000.0 / write_rate;
+		}
+		co_await write(min_LBA + log_cursor, LOG_TAG, start_time);
+		log_cursor = (log_cursor + 1) % log_size;
+		if (++num_memtable_pages == file_size) {
+			num_memtable_pages = 0;
+			num_immutable_memtables++;
+			notify(memtable_full);
+		}
+	}
+}
+
+// Each memtable spans the whole key range, and its log segment can be trimmed once it is in a file
+Coroutine_Thread::Client LSM_Tree::flush_memtables() {
+	while (true) {
+		if (num_immutable_memtables == 0) {
+			co_await wait(memtable_full);
+			continue;
+		}
+		while (free_slots.empty()) {
+			co_await wait(slot_freed);
+		}
+		File* file = create_file(file_size, 0, 1);
+		co_await write_batch(get_range(file), file->id);
+		levels[0].push_back(file);
+		long segment_start = min_LBA + (num_flushed_memtables % (MAX_IMMUTABLE_MEMTABLES + 1)) * file_size;
+		co_await trim_batch(Address_Range(segment_start, segment_start + file_size - 1));
+		num_flushed_memtables++;
+		num_immutable_memtables--;
+		notify(writes_can_resume);
+		notify(compaction_possible);
+	}
+}
+
+// A file with no overlapping files in the next level is moved there without any IO.
+// Otherwise, the outputs are written in step with reading the inputs, like in a streaming merge.
+Coroutine_Thread::Client LSM_Tree::compact() {
+	while (true) {
+		Compaction compaction = pick_compaction();
+		if (compaction.inputs.empty()) {
+			co_await wait(compaction_possible);
+			continue;
+		}
+		if (compaction.level > 0 && compaction.inputs.size() == 1) {
+			install_compaction(compaction, compaction.inputs);
+			notify(compaction_possible);
+			continue;
+		}
+		double min_key = 1, max_key = 0;
+		long input_size = 0;
+		for (auto input : compaction.inputs) {
+			input->is_being_compacted = true;
+			min_key = min(min_key, input->min_key);
+			max_key = max(max_key, input->max_key);
+			input_size += input->size;
+		}
+		long output_size = max(1L, min(input_size, (long)ceil(dataset_size * (max_key - min_key))));
+		long num_outputs = (output_size + file_size - 1) / file_size;
+		vector<File*> outputs;
+		for (uint i = 0; i < compaction.inputs.size(); i++) {
+			co_await read_batch(get_range(compaction.inputs[i]));
+			while ((long)outputs.size() < num_outputs * (long)(i + 1) / (long)compaction.inputs.size()) {
+				long size = min((long)file_size, output_size - (long)outputs.size() * file_size);
+				double output_min_key = min_key + (max_key - min_key) * outputs.size() / num_outputs;
+				double output_max_key = min_key + (max_key - min_key) * (outputs.size() + 1) / num_outputs;
+				while (free_slots.empty()) {
+					co_await wait(slot_freed);
+				}
+				File* output = create_file(size, output_min_key, output_max_key);
+				co_await write_batch(get_range(output), output->id);
+				outputs.push_back(output);
+			}
+		}
+		install_compaction(compaction, outputs);
+		for (auto input : compaction.inputs) {
+			co_await trim_batch(get_range(input));
+			delete_file(input);
+			notify(slot_freed);
+		}
+		notify(writes_can_resume);
+		notify(compaction_possible);
+	}
+}
+
+// Level 0 is compacted first, since it holds back writes. Only one level 0 compaction can run at a time,
+// as it takes all level 1 files. Otherwise, the level with the highest size to target size ratio above 1 is compacted,
+// starting from the file after the last one compacted in that level.
+LSM_Tree::Compaction LSM_Tree::pick_compaction() {
+	Compaction compaction;
+	vector<File*> level_1_files = get_overlapping_files(1, 0, 1);
+	bool level_0_busy = false;
+	for (auto file : levels[0]) {
+		level_0_busy |= file->is_being_compacted;
+	}
+	for (auto file : level_1_files) {
+		level_0_busy |= file->is_being_compacted;
+	}
+	if (!level_0_busy && levels[0].size() >= LEVEL_0_COMPACTION_TRIGGER) {
+		compaction.level = 0;
+		compaction.inputs = levels[0];
+		compaction.inputs.insert(compaction.inputs.end(), level_1_files.begin(), level_1_files.end());
+		return compaction;
+	}
+	double best_score = 1;
+	for (uint level = 1; level < levels.size() - 1; level++) {
+		double score = get_level_size(level) / (double)get_target_size(level);
+		if (score <= best_score) {
+			continue;
+		}
+		vector<File*> const& candidates = levels[level];
+		uint first = 0;
+		while (first < candidates.size() && candidates[first]->min_key < compaction_cursors[level]) {
+			first++;
+		}
+		for (uint i = 0; i < candidates.size(); i++) {
+			File* file = candidates[(first + i) % candidates.size()];
+			if (file->is_being_compacted) {
+				continue;
+			}
+			vector<File*> overlapping = get_overlapping_files(level + 1, file->min_key, file->max_key);
+			bool busy = false;
+			for (auto other : overlapping) {
+				busy |= other->is_being_compacted;
+			}
+			if (!busy) {
+				best_score = score;
+				compaction.level = level;
+				compaction.inputs = overlapping;
+				compaction.inputs.insert(compaction.inputs.begin(), file);
+				break;
+			}
+		}
+	}
+	if (compaction.level > 0) {
+		compaction_cursors[compaction.level] = compaction.inputs.front()->max_key;
+	}
+	return compaction;
+}
+
+void LSM_Tree::install_compaction(Compaction const& compaction, vector<File*> const& outputs) {
+	for (auto input : compaction.inputs) {
+		for (uint level = compaction.level; level <= (uint)compaction.level + 1; level++) {
+			vector<File*>::iterator position = find(levels[level].begin(), levels[level].end(), input);
+			if (position != levels[level].end()) {
+				levels[level].erase(position);
+			}
+		}
+	}
+	vector<File*>& output_level = levels[compaction.level + 1];
+	for (auto output : outputs) {
+		output->is_being_compacted = false;
+		output_level.push_back(output);
+	}
+	sort(output_level.begin(), output_level.end(), [](File const* a, File const* b) { return a->min_key < b->min_key; });
+}
+
+LSM_Tree::File* LSM_Tree::create_file(long size, double min_key, double max_key) {
+	assert(!free_slots.empty() && size <= file_size);
+	long slot = *free_slots.begin();
+	free_slots.erase(free_slots.begin());
+	File* file = new File(file_id_generator++, slot, size, min_key, max_key);
+	files[file->id] = file;
+	return file;
+}
+
+void LSM_Tree::delete_file(File* file) {
+	free_slots.insert(file->slot);
+	files.erase(file->id);
+	delete file;
+}
+
+vector<LSM_Tree::File*> LSM_Tree::get_overlapping_files(int level, double min_key, double max_key) const {
+	vector<File*> overlapping;
+	for (auto file : levels[level]) {
+		if (file->min_key < max_key && file->max_key > min_key) {
+			overlapping.push_back(file);
+		}
+	}
+	return overlapping;
+}
+
+long LSM_Tree::get_level_size(int level) const {
+	long size = 0;
+	for (auto file : levels[level]) {
+		size += file->size;
+	}
+	return size;
+}
+
+long LSM_Tree::get_target_size(int level) const {
+	long size = LEVEL_0_COMPACTION_TRIGGER * file_size;
+	for (int i = 1; i < level; i++) {
+		size *= level_fanout;
+	}
+	return size;
+}
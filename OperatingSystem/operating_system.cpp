@@ -14,19 +14,33 @@ OperatingSystem::OperatingSystem()
 	: ssd(new Ssd()),
 	  threads(),
 	  NUM_WRITES_TO_STOP_AFTER(UNDEFINED),
+	  outstanding_ios(),
+	  plugged_requests(),
+	  merged_requests(),
+	  num_merged_ios(0),
+	  num_merged_requests(0),
+	  page_cache(NULL),
+	  queued_ios(),
+	  last_submission_time(0),
+	  memory_completions(),
 	  num_writes_completed(0),
-	  idle_time(0),
 	  time(0),
 	  scheduler(NULL),
 	  progress_meter_granularity(20),
-	  counter_for_user(0)
+	  counter_for_user(0),
+	  is_sampling(false)
 {
 	ssd->set_operating_system(this);
 	thread_id_generator = 0;
 	if (OS_SCHEDULER == 0) {
 		scheduler = new FIFO_OS_Scheduler();
-	} else {
+	} else if (OS_SCHEDULER == 1) {
 		scheduler = new FAIR_OS_Scheduler();
+	} else {
+		scheduler = new Weighted_Fair_OS_Scheduler();
+	}
+	if (PAGE_CACHE_SIZE > 0) {
+		page_cache = new Page_Cache(this, PAGE_CACHE_SIZE);
 	}
 	//assert(MAX_SSD_QUEUE_SIZE >= SSD_SIZE * PACKAGE_SIZE);
 }
@@ -37,12 +51,16 @@ void OperatingSystem::set_threads(vector<Thread*> new_threads) {
 	}
 	historical_threads.clear();
 	num_writes_completed = 0;
+	for (auto entry : threads) {
+		scheduler->register_thread_removal(entry.first);
+	}
 	threads.clear();
 	for (auto t : new_threads) {
 		t->init(this, time);
 		int new_id = ++thread_id_generator;
 		threads[new_id] = t;
 		historical_threads.push_back(t);
+		scheduler->register_thread_update(new_id, t);
 	}
 }
 
@@ -62,35 +80,57 @@ OperatingSystem::~OperatingSystem() {
 	}
 	threads.clear();
 	delete scheduler;
+	delete page_cache;
 }
 
-void OperatingSystem::check_if_stuck(bool no_pending_event, bool queue_is_full) {
-	const int idle_limit = 3000000;
-	if (idle_time > 100000 && idle_time % 100000 == 0) {
-		printf("Idle for %f seconds. No_pending_event=%d  Queue_is_full=%d\n", (double) idle_time / 1000000, no_pending_event, queue_is_full);
-		PRINT_LEVEL = 2;
-	}
-	if (idle_time >= idle_limit) {
-		printf("\n");
+// Nothing can be dispatched and the SSD has no events left that could ever complete the outstanding IOs
+void OperatingSystem::report_deadlock(bool queue_is_full) const {
+	printf("\n");
+	if (outstanding_ios.size() > 0) {
+		fprintf(stderr, "For some reason, application IOs are getting stuck inside the SSD and never making it back to the OS.\n");
+		fprintf(stderr, "Normally the SSD invokes the OS's register_event_completion method whenever an application IO completes.\n");
+		fprintf(stderr, "This isn't happening, though. The SSD has no more events to execute, but these IOs are still outstanding.\n");
 		if (queue_is_full) {
-			fprintf(stderr, "For some reason, application IOs are getting stuck inside the SSD and never making it back to the OS.\n");
-			fprintf(stderr, "Normally the SSD invokes the OS's register_event_completion method whenever an application IO completes.\n");
-			fprintf(stderr, "This isn't happening, though. Since these IOs are still in the IO queue, we are stuck. We cannot submit any more IOs.\n");
-			fprintf(stderr, "The IOs that were submitted but never completed have the following application IDs:\n");
-		}
-		else if (no_pending_event) {
-			fprintf(stderr, "For some reason, the application threads are not submitting IOs.\n");
-			fprintf(stderr, "This means we are not making any progress. We are stuck an infinite loop.\n");
-			fprintf(stderr, "Hint: try to debug the OS_Scheduler method \"pick\", and try to see why the threads are not submitting IOs.\n");
+			fprintf(stderr, "Since these IOs fill the IO queue, we cannot submit any more IOs.\n");
 		}
-		for (auto it : currently_executing_ios) {
-			printf("%d ", it);
+		fprintf(stderr, "The IOs that were submitted but never completed have the following application IDs:\n");
+		outstanding_ios.print(stderr);
+	}
+	else {
+		fprintf(stderr, "For some reason, the application threads are not submitting IOs.\n");
+		fprintf(stderr, "There are %d threads that are not finished, but none of them has an IO to dispatch and no IOs are outstanding.\n", (int)threads.size());
+		fprintf(stderr, "Hint: try to debug the OS_Scheduler method \"pick\", and try to see why the threads are not submitting IOs.\n");
+	}
+	if (page_cache != NULL && page_cache->has_blocked_ios()) {
+		fprintf(stderr, "Some IOs are blocked in the page cache, waiting for writeback or readahead IOs that are not executing.\n");
+	}
+	throw;
+}
+
+// A thread with follow up threads is a phase of the workload, like preconditioning, that the run should not end in
+bool OperatingSystem::has_pending_follow_up_threads() const {
+	for (auto thread : threads) {
+		if (!thread.second->get_follow_up_threads().empty()) {
+			return true;
 		}
+	}
+	return false;
+}
+
+// The sampled simulation wants a different mode than the one the SSD is in. No IOs are dispatched until the switch is made.
+bool OperatingSystem::is_switching_simulation_mode() {
+	return is_sampling && Sampled_Simulation::is_functional() != ssd->get_scheduler()->is_fast_forwarding();
+}
 
-		printf("\n");
-		throw;
+// The fast forwarder can only take over an idle SSD, so the timed IOs are left to finish first.
+// Statistics are only recorded for the timed IOs.
+void OperatingSystem::switch_simulation_mode() {
+	bool functional = Sampled_Simulation::is_functional();
+	if (functional && !ssd->is_idle()) {
+		return;
 	}
-	idle_time++;
+	ssd->get_scheduler()->set_fast_forward(functional);
+	StatisticsGatherer::set_record_statistics(!functional);
 }
 
 void OperatingSystem::print_progess() {
@@ -105,52 +145,176 @@ void OperatingSystem::print_progess() {
 	}
 }
 
-// The operating system loops until one of two conditions holds:
-// 		- no thread
+// The operating system is an event loop that runs until the IO limit or steady state is reached, or no threads or outstanding IOs are left.
+// In each step, it dispatches an IO queued by the page cache or the IO chosen by the OS scheduler if there is room in the SSD queue.
+// Otherwise, it submits any plugged requests, and if there are none, it completes the IO served from memory that finishes first,
+// unless the SSD has an earlier event. In that case, it lets the SSD execute its soonest events, which advances time directly to the next event in the SSD.
+// Completions are handled in register_event_completion, which in turn lets threads submit new IOs.
+// If nothing can be dispatched and the SSD has nothing left to execute, no progress is possible and we report a deadlock.
+// With sampled simulation, the loop switches the SSD between functional and timed execution, as the samples require.
 void OperatingSystem::run() {
-
 	bool finished_experiment = false, still_more_work = true;
+	is_sampling = SAMPLING_PERIOD > 0 && ssd->get_scheduler()->can_fast_forward() && !ssd->get_scheduler()->is_fast_forwarding();
 	do {
-		int thread_id = scheduler->pick(threads);
-		bool no_pending_event = thread_id == UNDEFINED;
-		bool queue_is_full = currently_executing_ios.size() >= MAX_SSD_QUEUE_SIZE;
-		int queue_size = currently_executing_ios.size();
-		if (no_pending_event || queue_is_full) {
-			check_if_stuck(no_pending_event, queue_is_full);
+		if (is_switching_simulation_mode()) {
+			switch_simulation_mode();
+		}
+		bool queue_is_full = outstanding_ios.size() + plugged_requests.size() >= MAX_SSD_QUEUE_SIZE;
+		bool can_dispatch = !queue_is_full && !is_switching_simulation_mode();
+		int thread_id = !can_dispatch || !queued_ios.empty() ? UNDEFINED : scheduler->pick(threads);
+		if (can_dispatch && !queued_ios.empty()) {
+			dispatch_queued_io();
+		}
+		else if (thread_id != UNDEFINED) {
+			dispatch_event(thread_id);
+		}
+		else if (!plugged_requests.empty()) {
+			unplug();
+		}
+		else if (!memory_completions.empty() && memory_completions.begin()->first <= ssd->get_next_event_time()) {
+			complete_memory_io();
+		}
+		else if (!ssd->is_idle()) {
 			ssd->progress_since_os_is_waiting();
 		}
 		else {
-			dispatch_event(thread_id);
+			report_deadlock(queue_is_full);
 		}
 		print_progess();
 
-		finished_experiment = NUM_WRITES_TO_STOP_AFTER != UNDEFINED && NUM_WRITES_TO_STOP_AFTER <= num_writes_completed;
-		still_more_work = currently_executing_ios.size() > 0 || threads.size() > 0;
-		//printf("num_writes   %d\n", num_writes_completed);
+		finished_experiment = (NUM_WRITES_TO_STOP_AFTER != UNDEFINED && NUM_WRITES_TO_STOP_AFTER <= num_writes_completed)
+				|| (Steady_State_Monitor::has_reached_steady_state() && !has_pending_follow_up_threads());
+		still_more_work = outstanding_ios.size() > 0 || threads.size() > 0;
 	} while (!finished_experiment && still_more_work);
 
+	if (Steady_State_Monitor::has_reached_steady_state() && !has_pending_follow_up_threads()) {
+		printf("Stopped at steady state, after %d IOs\n", num_writes_completed);
+	}
+	unplug();
+	if (OS_MAX_REQUEST_SIZE > 1) {
+		printf("Merged %ld IOs into %ld requests\n", num_merged_ios, num_merged_requests);
+	}
+	if (page_cache != NULL) {
+		page_cache->print_stats();
+	}
 	for (auto entry : threads) {
 		Thread* t = entry.second;
 		t->stop();
 	}
+	if (is_sampling) {
+		ssd->get_scheduler()->set_fast_forward(false);
+		StatisticsGatherer::set_record_statistics(true);
+		is_sampling = false;
+		Sampled_Simulation::print();
+	}
 }
 
 void OperatingSystem::dispatch_event(int thread_id) {
-	idle_time = 0;
-	Event* event = threads[thread_id]->pop();
+	Thread* thread = threads[thread_id];
+	Event* event = thread->pop();
+	scheduler->register_dispatch(thread_id, thread, *event);
+	scheduler->register_thread_update(thread_id, thread);
 	if (event->get_start_time() < time) {
 		event->incr_os_wait_time(time - event->get_start_time());
 	}
-	//printf("submitting:   " ); event->print();
+	if (page_cache != NULL && page_cache->absorb(event, thread_id)) {
+		return;
+	}
+	if (event->get_event_type() == FSYNC) {
+		// Without a page cache there is nothing to write back
+		complete_in_memory(event, thread_id);
+	} else if (OS_MAX_REQUEST_SIZE > 1) {
+		plug(event, thread_id);
+	} else {
+		submit_request(event, thread_id);
+	}
+}
 
-	currently_executing_ios.insert(event->get_application_io_id());
-	app_id_to_thread_id_mapping[event->get_application_io_id()] = thread_id;
+void OperatingSystem::dispatch_queued_io() {
+	pair<Event*, int> io = queued_ios.front();
+	queued_ios.pop_front();
+	if (OS_MAX_REQUEST_SIZE > 1) {
+		plug(io.first, io.second);
+	} else {
+		submit_request(io.first, io.second);
+	}
+}
 
-	//printf("dispatching:\t"); event->print();
+// IOs from the page cache are queued rather than submitted directly, so that they respect the SSD queue size
+void OperatingSystem::queue_for_submission(Event* event, int thread_id) {
+	queued_ios.push_back(pair<Event*, int>(event, thread_id));
+}
 
+// The IO is completed by the run loop once the SSD has no earlier events, so completions reach the threads in time order
+void OperatingSystem::complete_in_memory(Event* event, int thread_id) {
+	memory_completions.insert(pair<double, pair<Event*, int> >(event->get_current_time(), pair<Event*, int>(event, thread_id)));
+}
+
+void OperatingSystem::complete_memory_io() {
+	pair<Event*, int> io = memory_completions.begin()->second;
+	memory_completions.erase(memory_completions.begin());
+	complete_event(io.first, io.second);
+}
+
+// IOs completed from memory let threads issue IOs that are older than IOs already submitted to the SSD.
+// The SSD receives IOs in order, so such an IO waits in the OS until the last submission time.
+void OperatingSystem::submit_request(Event* event, int thread_id) {
+	if (event->get_ssd_submission_time() < last_submission_time) {
+		event->incr_os_wait_time(last_submission_time - event->get_ssd_submission_time());
+	}
+	last_submission_time = event->get_ssd_submission_time();
+	outstanding_ios.insert(event->get_application_io_id(), thread_id);
 	ssd->submit(event);
 }
 
+// Tries to merge the IO with a plugged request. Tagged IOs, flexible reads and zone commands are never merged.
+// The plug is flushed first if the IO arrived after the plug window of the oldest plugged request,
+// and flushed after merging if the request reached the maximal request size.
+// Flushing the whole plug rather than a single request keeps the requests in the order in which they were plugged.
+void OperatingSystem::plug(Event* event, int thread_id) {
+	event_type type = event->get_event_type();
+	bool can_be_merged = event->get_tag() == UNDEFINED && !event->is_flexible_read() && event->get_zone_command() == NO_ZONE_COMMAND
+			&& (type == READ || type == WRITE || type == TRIM);
+	if (!plugged_requests.empty() && event->get_current_time() > plugged_requests.front().earliest_arrival + OS_PLUG_WINDOW) {
+		unplug();
+	}
+	if (!can_be_merged) {
+		unplug();
+		submit_request(event, thread_id);
+		return;
+	}
+	for (auto& request : plugged_requests) {
+		if (request.can_merge(*event)) {
+			request.merge(event, thread_id);
+			if (request.get_size() >= OS_MAX_REQUEST_SIZE) {
+				unplug();
+			}
+			return;
+		}
+	}
+	plugged_requests.push_back(plugged_request(event, thread_id));
+}
+
+// Submits all plugged requests to the SSD. A request made of several IOs is submitted as one multi-page IO.
+// It is submitted once its last IO has arrived, so the IOs that arrived before that accumulate OS wait time.
+void OperatingSystem::unplug() {
+	for (auto& request : plugged_requests) {
+		if (request.parts.size() == 1) {
+			submit_request(request.parts.front().first, request.parts.front().second);
+			continue;
+		}
+		for (auto part : request.parts) {
+			part.first->incr_os_wait_time(request.latest_arrival - part.first->get_current_time());
+		}
+		Event* merged = new Event(request.type, request.min_lba, request.get_size(), request.latest_arrival);
+		merged_requests[merged->get_application_io_id()] = request.parts;
+		num_merged_ios += request.parts.size();
+		num_merged_requests++;
+		submit_request(merged, request.parts.front().second);
+	}
+	plugged_requests.clear();
+}
+
 void OperatingSystem::setup_follow_up_threads(int thread_id, double current_time) {
 	vector<Thread*>& follow_up_threads = threads[thread_id]->get_follow_up_threads();
 	if (PRINT_LEVEL >= 1) printf("Switching to new follow up thread\n");
@@ -161,45 +325,71 @@ void OperatingSystem::setup_follow_up_threads(int thread_id, double current_time
 		int new_id = ++thread_id_generator;
 		threads[new_id] = t;
 		historical_threads.push_back(t);
+		scheduler->register_thread_update(new_id, t);
 	}
 	follow_up_threads.clear();
 }
 
 void OperatingSystem::register_event_completion(Event* event) {
+	uint application_io_id = event->get_application_io_id();
+	int thread_id = outstanding_ios.remove(application_io_id);
+	if (merged_requests.count(application_io_id) == 1) {
+		vector<pair<Event*, int> > parts = merged_requests[application_io_id];
+		merged_requests.erase(application_io_id);
+		for (auto part : parts) {
+			double time_in_ssd = event->get_current_time() - part.first->get_current_time();
+			part.first->incr_accumulated_wait_time(time_in_ssd);
+			part.first->incr_pure_ssd_wait_time(time_in_ssd);
+			complete_event(part.first, part.second);
+		}
+		delete event;
+	} else {
+		complete_event(event, thread_id);
+	}
 
-	//bool queue_was_full = currently_executing_ios.size() == MAX_SSD_QUEUE_SIZE;
-	currently_executing_ios.erase(event->get_application_io_id());
-
-	//printf("finished:\t"); event->print();
-	//printf("queue size:\t%d\n", currently_executing_ios_counter);
+	if (is_switching_simulation_mode()) {
+		return;
+	}
+	int thread_with_soonest_event = scheduler->pick(threads);
+	if (thread_with_soonest_event != UNDEFINED) {
+		dispatch_event(thread_with_soonest_event);
+	}
+}
 
-	long thread_id = app_id_to_thread_id_mapping.at(event->get_application_io_id());
-	app_id_to_thread_id_mapping.erase(event->get_application_io_id());
+void OperatingSystem::complete_event(Event* event, int thread_id) {
+	if (thread_id == KERNEL_THREAD_ID) {
+		page_cache->register_kernel_io_completion(*event);
+		time = max(time, event->get_current_time());
+		scheduler->set_time(time);
+		delete event;
+		return;
+	}
+	if (page_cache != NULL && event->get_event_type() == READ && !event->is_flexible_read()) {
+		page_cache->register_read_completion(*event);
+	}
 	Thread* thread = threads[thread_id];
 	thread->register_event_completion(event);
+	scheduler->register_thread_update(thread_id, thread);
 
-	if (!event->get_noop() /*&& event->get_event_type() == WRITE*/ && event->get_event_type() != TRIM) {
+	if (!event->get_noop() /*&& event->get_event_type() == WRITE*/ && event->get_event_type() != TRIM && event->get_event_type() != FSYNC) {
 		num_writes_completed++;
+		if (is_sampling) {
+			Sampled_Simulation::register_completed_event(*event);
+		}
 	}
 
 	if (thread->is_finished() && thread->get_num_ongoing_IOs() == 0) {
+		Steady_State_Monitor::register_workload_change(event->get_current_time());
+		Sampled_Simulation::register_workload_change();
 		setup_follow_up_threads(thread_id, event->get_current_time());
 		threads.erase(thread_id);
-	}
-	if (!event->get_noop()) {
-		//assert(time <= event->get_current_time() + 1);
+		scheduler->register_thread_removal(thread_id);
 	}
 	time = max(time, event->get_current_time());
-
-	int thread_with_soonest_event = scheduler->pick(threads);
-	if (thread_with_soonest_event != UNDEFINED) {
-		dispatch_event(thread_with_soonest_event);
-	}
-
+	scheduler->set_time(time);
 	delete event;
 }
 
-
 void OperatingSystem::set_num_writes_to_stop_after(long num_writes) {
 	NUM_WRITES_TO_STOP_AFTER = num_writes;
 }
@@ -214,6 +404,96 @@ void OperatingSystem::init_threads() {
 	for (auto t : threads) {
 		Thread* thread = t.second;
 		thread->init(this, 0);
+		scheduler->register_thread_update(t.first, thread);
 	}
 }
 
+// =================  outstanding_io_table  =============================
+
+OperatingSystem::outstanding_io_table::outstanding_io_table()
+	: slots(), mask(0), num_ios(0)
+{
+	uint num_slots = 1;
+	while (num_slots < 2 * (uint)MAX_SSD_QUEUE_SIZE) {
+		num_slots *= 2;
+	}
+	slots = vector<slot>(num_slots);
+	mask = num_slots - 1;
+}
+
+void OperatingSystem::outstanding_io_table::insert(uint application_io_id, int thread_id) {
+	assert(num_ios < (int)slots.size() / 2);
+	uint index = home_slot(application_io_id);
+	while (slots[index].thread_id != UNDEFINED) {
+		index = (index + 1) & mask;
+	}
+	slots[index].application_io_id = application_io_id;
+	slots[index].thread_id = thread_id;
+	num_ios++;
+}
+
+// Returns the ID of the thread that submitted the IO.
+// The slots following the removed one are shifted back, so lookups never need tombstones.
+int OperatingSystem::outstanding_io_table::remove(uint application_io_id) {
+	uint index = home_slot(application_io_id);
+	while (slots[index].application_io_id != application_io_id || slots[index].thread_id == UNDEFINED) {
+		assert(slots[index].thread_id != UNDEFINED);
+		index = (index + 1) & mask;
+	}
+	int thread_id = slots[index].thread_id;
+	uint next = index;
+	while (true) {
+		next = (next + 1) & mask;
+		if (slots[next].thread_id == UNDEFINED) {
+			break;
+		}
+		uint home = home_slot(slots[next].application_io_id);
+		bool can_stay = index <= next ? index < home && home <= next : index < home || home <= next;
+		if (!can_stay) {
+			slots[index] = slots[next];
+			index = next;
+		}
+	}
+	slots[index] = slot();
+	num_ios--;
+	return thread_id;
+}
+
+void OperatingSystem::outstanding_io_table::print(FILE* stream) const {
+	for (auto s : slots) {
+		if (s.thread_id != UNDEFINED) {
+			fprintf(stream, "%d ", s.application_io_id);
+		}
+	}
+	fprintf(stream, "\n");
+}
+
+// =================  plugged_request  =============================
+
+OperatingSystem::plugged_request::plugged_request(Event* event, int thread_id)
+	: type(event->get_event_type()),
+	  min_lba(event->get_logical_address()),
+	  max_lba(event->get_logical_address() + event->get_size() - 1),
+	  earliest_arrival(event->get_current_time()),
+	  latest_arrival(event->get_current_time()),
+	  parts(1, pair<Event*, int>(event, thread_id))
+{}
+
+bool OperatingSystem::plugged_request::can_merge(Event const& event) const {
+	long lba = event.get_logical_address();
+	bool back_merge = lba == max_lba + 1;
+	bool front_merge = lba + (long)event.get_size() == min_lba;
+	return event.get_event_type() == type && (back_merge || front_merge)
+			&& get_size() + event.get_size() <= OS_MAX_REQUEST_SIZE
+			&& event.get_current_time() <= earliest_arrival + OS_PLUG_WINDOW;
+}
+
+void OperatingSystem::plugged_request::merge(Event* event, int thread_id) {
+	if (event->get_logical_address() == max_lba + 1) {
+		max_lba += event->get_size();
+	} else {
+		min_lba = event->get_logical_address();
+	}
+	latest_arrival = max(latest_arrival, event->get_current_time());
+	parts.push_back(pair<Event*, int>(event, thread_id));
+}
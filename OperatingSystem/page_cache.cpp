@@ -0,0 +1,382 @@
+/*
+ * page_cache.cpp
+ *
+ *  A host page cache with writeback and readahead, used by the operating system.
+ */
+
+#include "../ssd.h"
+using namespace ssd;
+
+// Tagged IOs carry the size of their file as a hint, but only access one page
+static long get_num_pages(Event const& event) {
+	return event.get_tag() == UNDEFINED ? event.get_size() : 1;
+}
+
+Page_Cache::Page_Cache(OperatingSystem* os, long capacity)
+	: os(os),
+	  capacity(capacity),
+	  dirty_limit(capacity * PAGE_CACHE_DIRTY_RATIO),
+	  background_dirty_limit(capacity * PAGE_CACHE_DIRTY_BACKGROUND_RATIO),
+	  pages(),
+	  lru(),
+	  dirty_pages(),
+	  pages_under_writeback(),
+	  writeback_cursor(0),
+	  readahead(),
+	  reads_waiting_for_readahead(),
+	  trimmed_pages(),
+	  throttled_writes(),
+	  fsync_barriers(),
+	  deferred_trims(),
+	  num_read_hits(0),
+	  num_read_misses(0),
+	  num_readahead_pages(0),
+	  num_writeback_pages(0),
+	  num_throttled_writes(0),
+	  num_fsyncs(0)
+{}
+
+// Returns true if the cache takes over the IO. Otherwise, the OS must submit it to the SSD.
+// Tagged writes bypass the cache like direct IO, so that the SSD still sees their tags.
+bool Page_Cache::absorb(Event* event, int thread_id) {
+	event_type type = event->get_event_type();
+	if (type == READ && !event->is_flexible_read()) {
+		return absorb_read(event, thread_id);
+	}
+	else if (type == WRITE && event->get_tag() == UNDEFINED) {
+		absorb_write(event, thread_id);
+		return true;
+	}
+	else if (type == FSYNC) {
+		absorb_fsync(event, thread_id);
+		return true;
+	}
+	else if (type == TRIM) {
+		return absorb_trim(event, thread_id);
+	}
+	else if (type == WRITE) {
+		invalidate(*event);
+	}
+	return false;
+}
+
+// A read hit completes at memory latency, unless some of its pages are still being read ahead.
+// In that case, it completes once their data arrives.
+bool Page_Cache::absorb_read(Event* event, int thread_id) {
+	long first = event->get_logical_address();
+	long last = first + get_num_pages(*event) - 1;
+	bool is_hit = true, data_arrived = true;
+	for (long lba = first; lba <= last && is_hit; lba++) {
+		is_hit = pages.count(lba) == 1;
+		data_arrived = data_arrived && is_hit && !pages[lba].reading;
+	}
+	if (is_hit) {
+		num_read_hits++;
+		for (long lba = first; lba <= last; lba++) {
+			if (insert(lba).reading) {
+				reads_waiting_for_readahead[lba].push_back(pair<Event*, int>(event, thread_id));
+			}
+		}
+	} else {
+		num_read_misses++;
+	}
+	read_ahead(*event, thread_id);
+	if (is_hit && data_arrived) {
+		complete(event, thread_id, event->get_current_time());
+	}
+	return is_hit;
+}
+
+void Page_Cache::absorb_write(Event* event, int thread_id) {
+	long first = event->get_logical_address();
+	long last = first + get_num_pages(*event) - 1;
+	for (long lba = first; lba <= last; lba++) {
+		cached_page& page = insert(lba);
+		if (!page.dirty) {
+			page.dirty = true;
+			dirty_pages.insert(lba);
+		}
+	}
+	evict();
+	if (is_over_dirty_limit()) {
+		throttled_writes.push_back(pair<Event*, int>(event, thread_id));
+		num_throttled_writes++;
+	} else {
+		complete(event, thread_id, event->get_current_time());
+	}
+	write_back(event->get_current_time());
+}
+
+// Only pages that are dirty or under writeback when the barrier arrives must be persisted before it completes.
+void Page_Cache::absorb_fsync(Event* event, int thread_id) {
+	num_fsyncs++;
+	blocked_io barrier(event, thread_id);
+	barrier.pending.insert(dirty_pages.begin(), dirty_pages.end());
+	barrier.pending.insert(pages_under_writeback.begin(), pages_under_writeback.end());
+	if (barrier.pending.empty()) {
+		complete(event, thread_id, event->get_current_time());
+		return;
+	}
+	fsync_barriers.push_back(barrier);
+	write_back(event->get_current_time());
+}
+
+// The SSD cannot execute a trim to a logical address while another IO to it is executing,
+// so the trim is held back until the writeback and readahead IOs to its pages are done.
+// Pages that were trimmed or never written, and were only written to the cache since, hold no data in the SSD,
+// so a trim to such pages completes in memory. Threads only trim pages after their direct writes to them completed,
+// so a page that is not mapped by the FTL and is not under writeback has no write executing in the SSD.
+bool Page_Cache::absorb_trim(Event* event, int thread_id) {
+	blocked_io trim(event, thread_id);
+	long first = event->get_logical_address();
+	long last = first + get_num_pages(*event) - 1;
+	FtlParent* ftl = os->get_ssd()->get_ftl();
+	bool is_empty_in_ssd = true;
+	for (long lba = first; lba <= last; lba++) {
+		bool is_under_writeback = pages_under_writeback.count(lba) == 1;
+		if (is_under_writeback || (pages.count(lba) == 1 && pages[lba].reading)) {
+			trim.pending.insert(lba);
+		}
+		bool is_unmapped = !is_under_writeback && ftl->get_physical_address(lba).valid == NONE;
+		is_empty_in_ssd = is_empty_in_ssd && (trimmed_pages.count(lba) == 1 || is_unmapped);
+	}
+	invalidate(*event);
+	if (is_empty_in_ssd) {
+		complete(event, thread_id, event->get_current_time());
+		return true;
+	}
+	if (trim.pending.empty()) {
+		return false;
+	}
+	deferred_trims.push_back(trim);
+	return true;
+}
+
+// Trims and direct writes make the cached copies of their pages obsolete, so the pages are dropped even if they are dirty.
+// The SSD executes IOs to the same logical address in arrival order, so a writeback that is already executing cannot overwrite them.
+void Page_Cache::invalidate(Event const& event) {
+	long first = event.get_logical_address();
+	long last = first + get_num_pages(event) - 1;
+	for (long lba = first; lba <= last; lba++) {
+		if (event.get_event_type() == TRIM) {
+			trimmed_pages.insert(lba);
+		} else {
+			trimmed_pages.erase(lba);
+		}
+		if (pages.count(lba) == 0) {
+			continue;
+		}
+		lru.erase(pages[lba].lru_position);
+		pages.erase(lba);
+		dirty_pages.erase(lba);
+		release_barriers(lba, event.get_current_time());
+	}
+	release_throttled_writes(event.get_current_time());
+}
+
+// A thread's read that missed the cache has completed in the SSD
+void Page_Cache::register_read_completion(Event const& event) {
+	long first = event.get_logical_address();
+	long last = first + get_num_pages(event) - 1;
+	for (long lba = first; lba <= last; lba++) {
+		insert(lba);
+	}
+	evict();
+}
+
+void Page_Cache::register_kernel_io_completion(Event const& event) {
+	long lba = event.get_logical_address();
+	double time = event.get_current_time();
+	bool is_cached = pages.count(lba) == 1;
+	if (event.get_event_type() == WRITE) {
+		pages_under_writeback.erase(lba);
+		if (is_cached) {
+			pages[lba].under_writeback = false;
+		}
+		if (!is_cached || !pages[lba].dirty) {
+			release_barriers(lba, time);
+		}
+		release_trims(lba, time);
+		release_throttled_writes(time);
+		write_back(time);
+	} else {
+		if (is_cached) {
+			pages[lba].reading = false;
+		}
+		release_trims(lba, time);
+		vector<pair<Event*, int> > waiting_reads = reads_waiting_for_readahead[lba];
+		reads_waiting_for_readahead.erase(lba);
+		for (auto read : waiting_reads) {
+			long first = read.first->get_logical_address();
+			long last = first + get_num_pages(*read.first) - 1;
+			bool data_arrived = true;
+			for (long i = first; i <= last; i++) {
+				data_arrived = data_arrived && (pages.count(i) == 0 || !pages[i].reading);
+			}
+			if (data_arrived) {
+				complete(read.first, read.second, time);
+			}
+		}
+	}
+	evict();
+}
+
+bool Page_Cache::has_blocked_ios() const {
+	return !throttled_writes.empty() || !reads_waiting_for_readahead.empty() || !fsync_barriers.empty() || !deferred_trims.empty();
+}
+
+void Page_Cache::print_stats() const {
+	printf("Page cache: %ld read hits, %ld read misses, %ld pages read ahead, %ld pages written back, %ld throttled writes, %ld fsyncs\n",
+			num_read_hits, num_read_misses, num_readahead_pages, num_writeback_pages, num_throttled_writes, num_fsyncs);
+}
+
+// Inserts the page if it is not cached, and makes it the most recently used page
+Page_Cache::cached_page& Page_Cache::insert(long lba) {
+	if (pages.count(lba) == 1) {
+		cached_page& page = pages[lba];
+		lru.splice(lru.begin(), lru, page.lru_position);
+		return page;
+	}
+	lru.push_front(lba);
+	cached_page& page = pages[lba];
+	page.lru_position = lru.begin();
+	return page;
+}
+
+// Drops least recently used pages until the cache fits its capacity.
+// Pages that are dirty or have IOs executing cannot be dropped yet, so they are given a second chance instead.
+// If all pages are like that, the cache temporarily exceeds its capacity until writeback catches up.
+void Page_Cache::evict() {
+	long num_second_chances = 0;
+	while ((long)pages.size() > capacity && num_second_chances < (long)lru.size()) {
+		long lba = lru.back();
+		cached_page& page = pages[lba];
+		if (page.dirty || page.under_writeback || page.reading) {
+			lru.splice(lru.begin(), lru, page.lru_position);
+			num_second_chances++;
+		} else {
+			lru.pop_back();
+			pages.erase(lba);
+		}
+	}
+}
+
+// Like the Linux readahead, a thread that reads sequentially has the next window of pages read asynchronously
+// once it has consumed half of the current one, and the window doubles each time up to PAGE_CACHE_READAHEAD_MAX pages.
+// A read that is not sequential resets the window.
+// Addresses that were never written hold no data, so they are not read ahead.
+void Page_Cache::read_ahead(Event const& event, int thread_id) {
+	if (PAGE_CACHE_READAHEAD_MAX <= 0) {
+		return;
+	}
+	readahead_state& state = readahead[thread_id];
+	long first = event.get_logical_address();
+	long last = first + get_num_pages(event) - 1;
+	bool is_sequential = first == state.next_lba;
+	state.next_lba = last + 1;
+	if (!is_sequential) {
+		state.window = 0;
+		state.readahead_end = last;
+		return;
+	}
+	if (state.readahead_end - last > state.window / 2) {
+		return;
+	}
+	state.window = state.window == 0 ? min(4, PAGE_CACHE_READAHEAD_MAX) : min(state.window * 2, (long)PAGE_CACHE_READAHEAD_MAX);
+	long start = max(last, state.readahead_end) + 1;
+	long end = min(last + state.window, (long)NUMBER_OF_ADDRESSABLE_PAGES() - 1);
+	FtlParent* ftl = os->get_ssd()->get_ftl();
+	for (long lba = start; lba <= end; lba++) {
+		if (pages.count(lba) == 1 || trimmed_pages.count(lba) == 1 || ftl->get_physical_address(lba).valid == NONE) {
+			continue;
+		}
+		insert(lba).reading = true;
+		os->queue_for_submission(new Event(READ, lba, 1, event.get_current_time()), OperatingSystem::KERNEL_THREAD_ID);
+		num_readahead_pages++;
+	}
+	state.readahead_end = max(state.readahead_end, end);
+	evict();
+}
+
+// Writes back a batch of dirty pages if the background dirty limit is exceeded or an fsync barrier is waiting.
+// The next batch is only started once the current one is done. Each batch continues the sweep of the logical
+// address space where the previous batch stopped, and is submitted sorted by logical address,
+// so that adjacent pages can be merged into large requests.
+void Page_Cache::write_back(double time) {
+	bool is_needed = !fsync_barriers.empty() || (long)dirty_pages.size() > background_dirty_limit;
+	if (!pages_under_writeback.empty() || !is_needed || dirty_pages.empty()) {
+		return;
+	}
+	vector<long> batch;
+	set<long>::iterator it = dirty_pages.lower_bound(writeback_cursor);
+	while ((int)batch.size() < PAGE_CACHE_WRITEBACK_BATCH && !dirty_pages.empty()) {
+		if (it == dirty_pages.end()) {
+			it = dirty_pages.begin();
+		}
+		long lba = *it;
+		cached_page& page = pages[lba];
+		page.dirty = false;
+		page.under_writeback = true;
+		pages_under_writeback.insert(lba);
+		trimmed_pages.erase(lba);
+		batch.push_back(lba);
+		dirty_pages.erase(it++);
+	}
+	writeback_cursor = batch.back() + 1;
+	sort(batch.begin(), batch.end());
+	for (auto lba : batch) {
+		os->queue_for_submission(new Event(WRITE, lba, 1, time), OperatingSystem::KERNEL_THREAD_ID);
+	}
+	num_writeback_pages += batch.size();
+}
+
+void Page_Cache::release_throttled_writes(double time) {
+	while (!throttled_writes.empty() && !is_over_dirty_limit()) {
+		pair<Event*, int> write = throttled_writes.front();
+		throttled_writes.pop_front();
+		complete(write.first, write.second, time);
+	}
+}
+
+// The page has been persisted or trimmed, so the barriers no longer wait for it
+void Page_Cache::release_barriers(long lba, double time) {
+	list<blocked_io>::iterator it = fsync_barriers.begin();
+	while (it != fsync_barriers.end()) {
+		(*it).pending.erase(lba);
+		if ((*it).pending.empty()) {
+			complete((*it).event, (*it).thread_id, time);
+			it = fsync_barriers.erase(it);
+		} else {
+			it++;
+		}
+	}
+}
+
+// The trims are queued in the order in which they arrived, before any writeback that the completion triggers
+void Page_Cache::release_trims(long lba, double time) {
+	list<blocked_io>::iterator it = deferred_trims.begin();
+	while (it != deferred_trims.end()) {
+		(*it).pending.erase(lba);
+		if ((*it).pending.empty()) {
+			Event* trim = (*it).event;
+			if (time > trim->get_current_time()) {
+				trim->incr_os_wait_time(time - trim->get_current_time());
+			}
+			os->queue_for_submission(trim, (*it).thread_id);
+			it = deferred_trims.erase(it);
+		} else {
+			it++;
+		}
+	}
+}
+
+// IOs that were blocked until the given time accumulate OS wait time, and all IOs spend the memory access time
+void Page_Cache::complete(Event* event, int thread_id, double time) {
+	if (time > event->get_current_time()) {
+		event->incr_os_wait_time(time - event->get_current_time());
+	}
+	if (event->get_event_type() != FSYNC) {
+		event->incr_execution_time(PAGE_CACHE_ACCESS_DELAY * get_num_pages(*event));
+	}
+	os->complete_in_memory(event, thread_id);
+}
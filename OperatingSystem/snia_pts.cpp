@@ -0,0 +1,278 @@
+/*
+ * snia_pts.cpp
+ *
+ *  The IOPS, throughput and latency tests of the SNIA Solid State Storage Performance Test Specification.
+ */
+
+#include "../ssd.h"
+#include <numeric>
+using namespace ssd;
+
+// =================  SNIA_PTS_Results  =============================
+
+const double SNIA_PTS_Results::MAX_DATA_EXCURSION = 0.2;
+const double SNIA_PTS_Results::MAX_SLOPE_EXCURSION = 0.1;
+
+// Block sizes smaller than a page are run with one page, and sizes that map to the same number of pages are only run once
+static vector<int> get_block_sizes_in_pages(vector<double> const& block_sizes_in_KB) {
+	vector<int> block_sizes;
+	for (auto size : block_sizes_in_KB) {
+		int pages = max(1, (int)(size * 1024 / PAGE_SIZE));
+		if (find(block_sizes.begin(), block_sizes.end(), pages) == block_sizes.end()) {
+			block_sizes.push_back(pages);
+		}
+	}
+	return block_sizes;
+}
+
+// The points are in the order of the PTS: the outer loop is over the read/write mixes, and the inner one over the block sizes
+SNIA_PTS_Results::SNIA_PTS_Results(pts_test test)
+	: test(test),
+	  points(),
+	  tracked_point(UNDEFINED),
+	  rounds(1, vector<Measurement>()),
+	  steady_state_round(UNDEFINED),
+	  finished(false)
+{
+	vector<double> read_fractions;
+	vector<int> block_sizes;
+	if (test == PTS_IOPS) {
+		read_fractions = {1, 0.95, 0.65, 0.5, 0.35, 0.05, 0};
+		block_sizes = get_block_sizes_in_pages({1024, 128, 64, 32, 16, 8, 4, 0.5});
+	} else if (test == PTS_THROUGHPUT) {
+		read_fractions = {0, 1};
+		block_sizes = get_block_sizes_in_pages({1024, 128});
+	} else {
+		read_fractions = {1, 0.65, 0};
+		block_sizes = get_block_sizes_in_pages({8, 4, 0.5});
+	}
+	for (auto read_fraction : read_fractions) {
+		for (auto block_size : block_sizes) {
+			points.push_back(Point(block_size, read_fraction, test == PTS_THROUGHPUT));
+		}
+	}
+	// The largest block size is tracked in the throughput test, and the smallest one in the others
+	for (uint i = 0; i < points.size(); i++) {
+		bool is_tracked_size = points[i].block_size == (test == PTS_THROUGHPUT ? block_sizes.front() : block_sizes.back());
+		if (is_tracked_size && points[i].read_fraction == 0) {
+			tracked_point = i;
+		}
+	}
+	rounds.back().resize(points.size());
+}
+
+string SNIA_PTS_Results::get_test_name(pts_test test) {
+	return test == PTS_IOPS ? "iops" : test == PTS_THROUGHPUT ? "throughput" : "latency";
+}
+
+string SNIA_PTS_Results::get_mix_name(double read_fraction) {
+	stringstream name;
+	name << "R/W " << (int)round(read_fraction * 100) << "/" << (int)round((1 - read_fraction) * 100);
+	return name.str();
+}
+
+void SNIA_PTS_Results::register_io(int point, double latency) {
+	assert(!finished);
+	rounds.back()[point].latencies.push_back(latency);
+}
+
+// Steady state is checked once the last point of a round has ended
+void SNIA_PTS_Results::end_point(int point, double duration) {
+	assert(!finished);
+	rounds.back()[point].duration = duration;
+	if (point == (int)points.size() - 1) {
+		check_steady_state();
+		if (!finished) {
+			rounds.push_back(vector<Measurement>(points.size()));
+		}
+	}
+}
+
+void SNIA_PTS_Results::check_steady_state() {
+	int last_round = rounds.size() - 1;
+	if (last_round + 1 >= WINDOW_SIZE) {
+		double sum = 0, min_value = numeric_limits<double>::infinity(), max_value = 0;
+		for (int round = last_round - WINDOW_SIZE + 1; round <= last_round; round++) {
+			double value = get_tracking_value(round);
+			sum += value;
+			min_value = min(min_value, value);
+			max_value = max(max_value, value);
+		}
+		double average = sum / WINDOW_SIZE;
+		double mean_x = (WINDOW_SIZE - 1) / 2.0, covariance = 0, variance = 0;
+		for (int x = 0; x < WINDOW_SIZE; x++) {
+			covariance += (x - mean_x) * (get_tracking_value(last_round - WINDOW_SIZE + 1 + x) - average);
+			variance += (x - mean_x) * (x - mean_x);
+		}
+		double slope = covariance / variance;
+		if (max_value - min_value <= MAX_DATA_EXCURSION * average && fabs(slope) * (WINDOW_SIZE - 1) <= MAX_SLOPE_EXCURSION * average) {
+			steady_state_round = last_round;
+			finished = true;
+		}
+	}
+	if (last_round + 1 >= MAX_ROUNDS) {
+		finished = true;
+	}
+}
+
+double SNIA_PTS_Results::get_tracking_value(int round) const {
+	Summary summary = summarize(tracked_point, round, round);
+	return test == PTS_IOPS ? summary.iops : test == PTS_THROUGHPUT ? summary.throughput : summary.mean_latency;
+}
+
+SNIA_PTS_Results::Summary SNIA_PTS_Results::summarize(int point, int first_round, int last_round) const {
+	double duration = 0;
+	vector<double> latencies;
+	for (int round = max(0, first_round); round <= last_round; round++) {
+		Measurement const& measurement = rounds[round][point];
+		duration += measurement.duration;
+		latencies.insert(latencies.end(), measurement.latencies.begin(), measurement.latencies.end());
+	}
+	sort(latencies.begin(), latencies.end());
+	Summary summary;
+	summary.iops = duration > 0 ? latencies.size() / (duration / 1000000) : 0;
+	summary.throughput = summary.iops * points[point].block_size * PAGE_SIZE / 1000000;
+	summary.mean_latency = latencies.empty() ? 0 : accumulate(latencies.begin(), latencies.end(), 0.0) / latencies.size();
+	long rank = (long)ceil(0.9999 * latencies.size());
+	summary.percentile_latency = latencies.empty() ? 0 : latencies[max(rank, 1L) - 1];
+	summary.max_latency = latencies.empty() ? 0 : latencies.back();
+	return summary;
+}
+
+// Each point is averaged over the measurement window, which is the last WINDOW_SIZE rounds if steady state was not reached
+void SNIA_PTS_Results::print_csv(FILE* stream) const {
+	int last_round = get_last_round();
+	fprintf(stream, "Block size (KiB), Access, R/W mix, IOPS, Throughput (MB/s), Mean latency (us), 99.99th percentile latency (us), Max latency (us)\n");
+	for (uint i = 0; i < points.size(); i++) {
+		Summary summary = summarize(i, last_round - WINDOW_SIZE + 1, last_round);
+		fprintf(stream, "%g, %s, %s, %f, %f, %f, %f, %f\n", points[i].block_size * PAGE_SIZE / 1024.0, points[i].is_sequential ? "Sequential" : "Random",
+				get_mix_name(points[i].read_fraction).c_str(), summary.iops, summary.throughput, summary.mean_latency, summary.percentile_latency, summary.max_latency);
+	}
+}
+
+// The rows are the block sizes and the columns the read/write mixes, like in the PTS report
+void SNIA_PTS_Results::print_iops_matrix_csv(FILE* stream) const {
+	int last_round = get_last_round();
+	vector<int> block_sizes;
+	vector<double> read_fractions;
+	for (auto point : points) {
+		if (find(block_sizes.begin(), block_sizes.end(), point.block_size) == block_sizes.end()) {
+			block_sizes.push_back(point.block_size);
+		}
+		if (find(read_fractions.begin(), read_fractions.end(), point.read_fraction) == read_fractions.end()) {
+			read_fractions.push_back(point.read_fraction);
+		}
+	}
+	fprintf(stream, "Block size (KiB)");
+	for (auto read_fraction : read_fractions) {
+		fprintf(stream, ", %s", get_mix_name(read_fraction).c_str());
+	}
+	fprintf(stream, "\n");
+	for (auto block_size : block_sizes) {
+		fprintf(stream, "%g", block_size * PAGE_SIZE / 1024.0);
+		for (auto read_fraction : read_fractions) {
+			for (uint i = 0; i < points.size(); i++) {
+				if (points[i].block_size == block_size && points[i].read_fraction == read_fraction) {
+					fprintf(stream, ", %f", summarize(i, last_round - WINDOW_SIZE + 1, last_round).iops);
+				}
+			}
+		}
+		fprintf(stream, "\n");
+	}
+}
+
+void SNIA_PTS_Results::print_steady_state_csv(FILE* stream) const {
+	int last_round = get_last_round();
+	if (steady_state_round != UNDEFINED) {
+		fprintf(stream, "# Steady state was reached in round %d\n", steady_state_round);
+	} else {
+		fprintf(stream, "# Steady state was not reached in %d rounds\n", last_round + 1);
+	}
+	string tracking_variable = test == PTS_IOPS ? "IOPS" : test == PTS_THROUGHPUT ? "Throughput (MB/s)" : "Mean latency (us)";
+	fprintf(stream, "Round, %s, In measurement window\n", tracking_variable.c_str());
+	for (int round = 0; round <= last_round; round++) {
+		fprintf(stream, "%d, %f, %d\n", round, get_tracking_value(round), round > last_round - WINDOW_SIZE);
+	}
+}
+
+// =================  SNIA_PTS_Thread  =============================
+
+SNIA_PTS_Thread::SNIA_PTS_Thread(long min_LBA, long max_LBA, SNIA_PTS_Results* results, int queue_depth, double point_duration, ulong randseed)
+	: Coroutine_Thread(queue_depth),
+	  min_LBA(min_LBA),
+	  max_LBA(max_LBA),
+	  results(results),
+	  point_duration(point_duration),
+	  num_precondition_IOs_left(0),
+	  sequential_cursor(0),
+	  current_point(UNDEFINED),
+	  num_clients_done(0),
+	  point_start_time(0),
+	  point_end_time(0),
+	  random_number_generator(randseed),
+	  point_started()
+{
+	assert(point_duration > 0);
+	long precondition_block_size = max(1, PRECONDITION_BLOCK_SIZE_IN_KB * 1024 / (int)PAGE_SIZE);
+	num_precondition_IOs_left = 2 * ((max_LBA - min_LBA + precondition_block_size) / precondition_block_size);
+}
+
+// The last client to finish a point starts the next one, and the clients return once the test is finished
+Coroutine_Thread::Client SNIA_PTS_Thread::run_client(int client_id) {
+	SNIA_PTS_Results::Point precondition(max(1, PRECONDITION_BLOCK_SIZE_IN_KB * 1024 / (int)PAGE_SIZE), 0, true);
+	while (num_precondition_IOs_left > 0) {
+		num_precondition_IOs_left--;
+		co_await write_batch(next_range(precondition));
+	}
+	while (!results->is_finished()) {
+		while (current_point != UNDEFINED && get_current_time() < point_end_time) {
+			int point_id = current_point;
+			SNIA_PTS_Results::Point const& point = results->get_points()[point_id];
+			Address_Range range = next_range(point);
+			bool is_read = random_number_generator() < point.read_fraction * 4294967296.0;
+			double start_time = get_current_time();
+			if (is_read) {
+				co_await read_batch(range);
+			} else {
+				co_await write_batch(range);
+			}
+			results->register_io(point_id, get_current_time() - start_time);
+		}
+		if (++num_clients_done < get_num_clients()) {
+			co_await wait(point_started);
+		} else {
+			start_next_point();
+			notify(point_started);
+		}
+	}
+}
+
+// Sequential IOs continue where the last one ended, and the last one before the end of the range may be shorter.
+// Random IOs are aligned to the block size.
+Address_Range SNIA_PTS_Thread::next_range(SNIA_PTS_Results::Point const& point) {
+	long first;
+	if (point.is_sequential) {
+		if (min_LBA + sequential_cursor > max_LBA) {
+			sequential_cursor = 0;
+		}
+		first = min_LBA + sequential_cursor;
+		sequential_cursor += point.block_size;
+	} else {
+		long num_blocks = (max_LBA - min_LBA + 1) / point.block_size;
+		first = min_LBA + (long)random_number_generator.below(num_blocks) * point.block_size;
+	}
+	return Address_Range(first, min(first + point.block_size - 1, max_LBA));
+}
+
+void SNIA_PTS_Thread::start_next_point() {
+	if (current_point != UNDEFINED) {
+		results->end_point(current_point, get_current_time() - point_start_time);
+	}
+	num_clients_done = 0;
+	if (results->is_finished()) {
+		return;
+	}
+	current_point = (current_point + 1) % results->get_points().size();
+	point_start_time = get_current_time();
+	point_end_time = point_start_time + point_duration;
+}
@@ -17,7 +17,8 @@ bool Thread::record_internal_statistics = false;
 Thread::Thread() :
 		finished(false), time(1), threads_to_start_when_this_thread_finishes(),
 		os(NULL), internal_statistics_gatherer(new StatisticsGatherer()),
-		external_statistics_gatherer(NULL), num_IOs_executing(0), io_queue(), stopped(false) {}
+		external_statistics_gatherer(NULL), num_IOs_executing(0), io_queue(), stopped(false),
+		io_weight(Weighted_Fair_OS_Scheduler::DEFAULT_IO_WEIGHT), latency_target(UNDEFINED) {}
 
 Thread::~Thread() {
 	for (auto t : threads_to_start_when_this_thread_finishes) {
@@ -30,14 +31,14 @@ Event* Thread::pop() {
 	if (io_queue.size() == 0) {
 		return NULL;
 	} else {
-		Event* next = io_queue.front();
-		io_queue.pop();
+		Event* next = io_queue.begin()->second;
+		io_queue.erase(io_queue.begin());
 		return next;
 	}
 }
 
 Event* Thread::peek() const {
-	return io_queue.size() == 0 ? NULL : io_queue.front();
+	return io_queue.size() == 0 ? NULL : io_queue.begin()->second;
 }
 
 void Thread::init(OperatingSystem* new_os, double new_time) {
@@ -98,7 +99,7 @@ void Thread::submit(Event* event) {
 		return;
 	}
 	event->set_start_time(event->get_current_time());
-	io_queue.push(event);
+	io_queue.insert(pair<double, Event*>(event->get_start_time(), event));
 	num_IOs_executing++;
 	if (!can_submit_more()) {
 		printf("Reached the maximum of events that can be submitted at the same time: %d\n", io_queue.size());
@@ -160,48 +161,120 @@ void Simple_Thread::handle_event_completion(Event* event) {
 	}
 }
 
-Random_IO_Pattern_Collision_Free::Random_IO_Pattern_Collision_Free(long min_LBA, long max_LBA, ulong seed) : IO_Pattern(min_LBA, max_LBA), random_number_generator(seed), counter(0) {
+// =================  Random_IO_Pattern_Collision_Free  =============================
+
+Random_IO_Pattern_Collision_Free::Random_IO_Pattern_Collision_Free(long min_LBA, long max_LBA, ulong seed)
+	: IO_Pattern(min_LBA, max_LBA),
+	  random_number_generator(seed),
+	  counter(0),
+	  half_bits(1),
+	  half_mask(1),
+	  keys(NUM_FEISTEL_ROUNDS)
+{
+	assert(max_LBA > min_LBA);
+	// The permuted domain has 2^(2 * half_bits) elements, which is the smallest even power of two covering the range.
+	// This keeps it below 4 times the range, so cycle walking needs fewer than 4 permutations per address on average.
+	ulong range = max_LBA - min_LBA;
+	while ((1UL << (2 * half_bits)) < range) {
+		half_bits++;
+	}
+	half_mask = (1UL << half_bits) - 1;
 	reinit();
 };
 
+// Draws new round keys, so each pass over the address space follows a different random order
 void Random_IO_Pattern_Collision_Free::reinit() {
-	candidates.clear();
-	candidates.reserve(max_LBA - min_LBA);
-	for (int i = min_LBA; i < max_LBA; i++ ) {
-		candidates.push_back(i);
+	counter = 0;
+	for (uint i = 0; i < keys.size(); i++) {
+		keys[i] = ((ulong)random_number_generator() << 32) | random_number_generator();
 	}
 }
 
-int Random_IO_Pattern_Collision_Free::next() {
-	bool found = false;
-	int index = UNDEFINED;
+ulong Random_IO_Pattern_Collision_Free::permute(ulong index) const {
+	ulong left = index >> half_bits;
+	ulong right = index & half_mask;
+	for (uint i = 0; i < keys.size(); i++) {
+		// the round function is the splitmix64 finalizer over the right half and the round key
+		ulong z = right + keys[i];
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9UL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebUL;
+		z ^= z >> 31;
+		ulong new_right = left ^ (z & half_mask);
+		left = right;
+		right = new_right;
+	}
+	return (left << half_bits) | right;
+}
 
-	do {
-		index = random_number_generator() % candidates.size();
-		if (candidates[index] != UNDEFINED) {
-			found = true;
-		}
-	} while (!found);
-	int lba = candidates[index];
-	candidates[index] = UNDEFINED;
-	if (candidates.size() == 1 && candidates.front() == UNDEFINED) {
+long Random_IO_Pattern_Collision_Free::next() {
+	ulong range = max_LBA - min_LBA;
+	if (counter == range) {
 		reinit();
-		counter = candidates.size();
 	}
-	if (++counter >= candidates.size() / 2) {
-		vector<int> new_candidates;
-		new_candidates.reserve(candidates.size() / 2);
-		for (auto i : candidates) {
-			if (i != UNDEFINED) {
-				new_candidates.push_back(i);
-			}
-		}
-		candidates = new_candidates;
-		//printf("size %d\n", candidates.size());
-		counter = 0;
+	// The permutation is a bijection on a domain slightly larger than the range.
+	// Walking the cycle until we land inside the range keeps it a bijection on the range itself.
+	ulong offset = counter++;
+	do {
+		offset = permute(offset);
+	} while (offset >= range);
+	return min_LBA + offset;
+}
+
+// =================  Zipf_IO_Pattern and Pareto_IO_Pattern  =============================
+
+// The splitmix64 finalizer, used to scatter popularity ranks across the range
+static long scatter_rank(ulong rank, ulong range) {
+	ulong z = rank;
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9UL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebUL;
+	z ^= z >> 31;
+	return z % range;
+}
+
+Zipf_IO_Pattern::Zipf_IO_Pattern(long min_LBA, long max_LBA, double theta, ulong seed)
+	: IO_Pattern(min_LBA, max_LBA),
+	  random_number_generator(seed),
+	  theta(theta),
+	  zeta_2(1 + pow(0.5, theta)),
+	  zeta_n(0)
+{
+	assert(max_LBA >= min_LBA && theta > 0 && theta != 1);
+	long num_terms = min(max_LBA - min_LBA + 1, MAX_ZETA_TERMS);
+	for (long i = 1; i <= num_terms; i++) {
+		zeta_n += pow(1.0 / i, theta);
 	}
+}
 
-	return lba;
+// The rejection-free method of Gray et al., as used by fio and YCSB
+long Zipf_IO_Pattern::next() {
+	long range = max_LBA - min_LBA + 1;
+	double alpha = 1.0 / (1.0 - theta);
+	double eta = (1.0 - pow(2.0 / range, 1.0 - theta)) / (1.0 - zeta_2 / zeta_n);
+	double uniform = random_number_generator();
+	double z = uniform * zeta_n;
+	long rank;
+	if (z < 1.0) {
+		rank = 0;
+	} else if (z < zeta_2) {
+		rank = 1;
+	} else {
+		rank = range * pow(eta * uniform - eta + 1.0, alpha);
+	}
+	return min_LBA + scatter_rank(min(max(rank, 0L), range - 1), range);
+}
+
+Pareto_IO_Pattern::Pareto_IO_Pattern(long min_LBA, long max_LBA, double h, ulong seed)
+	: IO_Pattern(min_LBA, max_LBA),
+	  random_number_generator(seed),
+	  power(log(h) / log(1.0 - h))
+{
+	assert(max_LBA >= min_LBA && h > 0 && h < 1);
+}
+
+long Pareto_IO_Pattern::next() {
+	long range = max_LBA - min_LBA + 1;
+	long rank = (range - 1) * pow(random_number_generator(), power);
+	return min_LBA + scatter_rank(rank, range);
 }
 
 // =================  Flexible_Reader_Thread  =============================
@@ -258,7 +331,7 @@ void Collision_Free_Asynchronous_Random_Thread::issue_first_IOs() {
 	if (0 < number_of_times_to_repeat) {
 		long address;
 		do {
-			address = min_LBA + random_number_generator() % (max_LBA - min_LBA + 1);
+			address = min_LBA + random_number_generator.below(max_LBA - min_LBA + 1);
 		} while (logical_addresses_submitted.count(address) == 1);
 		printf("num events submitted:  %d\n", logical_addresses_submitted.size());
 		logical_addresses_submitted.insert(address);
@@ -279,3 +352,56 @@ void Collision_Free_Asynchronous_Random_Thread::handle_event_completion(Event* e
 
 
 
+
+// =================  Checkpoint_Thread  =============================
+
+Checkpoint_Thread::Checkpoint_Thread(long min_LBA, long max_LBA, double dirty_page_rate, double checkpoint_interval, ulong randseed, int max_outstanding_writes)
+	: Thread(),
+	  min_LBA(min_LBA),
+	  max_LBA(max_LBA),
+	  dirty_page_rate(dirty_page_rate),
+	  checkpoint_interval(checkpoint_interval),
+	  last_checkpoint_time(0),
+	  max_outstanding_writes(max_outstanding_writes),
+	  dirty_pages(),
+	  random_number_generator(randseed)
+{
+	assert(checkpoint_interval > 0 && max_outstanding_writes > 0);
+}
+
+void Checkpoint_Thread::issue_first_IOs() {
+	last_checkpoint_time = get_current_time();
+	start_checkpoint(get_current_time() + checkpoint_interval);
+}
+
+// The next checkpoint starts once the last write of this one completes, or when its interval elapses
+void Checkpoint_Thread::handle_event_completion(Event* event) {
+	if (!dirty_pages.empty()) {
+		issue_writes(get_current_time());
+	} else if (get_num_ongoing_IOs() == 0) {
+		start_checkpoint(max(get_current_time(), last_checkpoint_time + checkpoint_interval));
+	}
+}
+
+// A database page dirtied twice since the last checkpoint is only written once
+void Checkpoint_Thread::start_checkpoint(double time) {
+	long num_dirtied = dirty_page_rate * (time - last_checkpoint_time) / 1000000;
+	int min_size = (MIN_DATABASE_PAGE_SIZE + PAGE_SIZE - 1) / PAGE_SIZE;
+	int max_size = (MAX_DATABASE_PAGE_SIZE + PAGE_SIZE - 1) / PAGE_SIZE;
+	for (long i = 0; i < num_dirtied; i++) {
+		int size = min_size + random_number_generator() % (max_size - min_size + 1);
+		long first = min_LBA + random_number_generator.below(max(1L, max_LBA - min_LBA + 2 - size));
+		for (long lba = first; lba < first + size && lba <= max_LBA; lba++) {
+			dirty_pages.insert(lba);
+		}
+	}
+	last_checkpoint_time = time;
+	issue_writes(time);
+}
+
+void Checkpoint_Thread::issue_writes(double time) {
+	while (get_num_ongoing_IOs() < max_outstanding_writes && !dirty_pages.empty()) {
+		submit(new Event(WRITE, *dirty_pages.begin(), 1, time));
+		dirty_pages.erase(dirty_pages.begin());
+	}
+}
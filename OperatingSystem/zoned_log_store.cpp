@@ -0,0 +1,158 @@
+/*
+ * zoned_log_store.cpp
+ *
+ *  A log-structured store that places its data itself on a zoned device.
+ */
+
+#include "../ssd.h"
+using namespace ssd;
+
+Zoned_Log_Store::Zoned_Log_Store(long num_keys, int num_clients, ulong randseed)
+	: Coroutine_Thread(num_clients + 1),
+	  num_keys(num_keys),
+	  zone_size(ZNS_FTL::get_zone_size()),
+	  num_zones(ZNS_FTL::get_num_zones()),
+	  is_zoned(false),
+	  key_locations(num_keys, UNDEFINED),
+	  key_versions(num_keys, 0),
+	  lba_keys(num_zones * zone_size, UNDEFINED),
+	  num_valid_keys(num_zones, 0),
+	  num_appends_issued(num_zones, 0),
+	  num_appends_completed(num_zones, 0),
+	  free_zones(),
+	  write_zone(UNDEFINED),
+	  cleaning_zone(UNDEFINED),
+	  num_key_writes(0),
+	  num_appends(0),
+	  num_zones_cleaned(0),
+	  random_number_generator(randseed),
+	  cleaning_needed(),
+	  zone_freed()
+{
+	assert(num_keys > 0 && num_keys <= (long)NUMBER_OF_ADDRESSABLE_PAGES() && num_clients > 0);
+	for (long zone = 0; zone < num_zones; zone++) {
+		free_zones.push_back(zone);
+	}
+}
+
+// Whether the device is zoned is only known once the thread runs on it. On a zoned device, the full zones must hold
+// more than the keys, so the cleaner always finds a zone with invalid keys.
+void Zoned_Log_Store::issue_first_IOs() {
+	is_zoned = dynamic_cast<ZNS_FTL*>(os->get_ssd()->get_ftl()) != NULL;
+	assert(!is_zoned || (ZNS_FTL::MAX_OPEN_ZONES >= 2 && num_keys < (num_zones - MIN_FREE_ZONES - 2) * zone_size));
+	Coroutine_Thread::issue_first_IOs();
+}
+
+Coroutine_Thread::Client Zoned_Log_Store::run_client(int client_id) {
+	return client_id == 0 ? clean() : write_keys();
+}
+
+Coroutine_Thread::Client Zoned_Log_Store::write_keys() {
+	while (true) {
+		long key = random_number_generator.below(num_keys);
+		if (!is_zoned) {
+			co_await write(key);
+			num_key_writes++;
+			num_appends++;
+			continue;
+		}
+		while ((write_zone == UNDEFINED || num_appends_issued[write_zone] == zone_size) && !can_open_zone_for_writes()) {
+			notify(cleaning_needed);
+			co_await wait(zone_freed);
+		}
+		long version = ++key_versions[key];
+		long lba = co_await zone_append(take_append_slot(write_zone));
+		num_key_writes++;
+		num_appends++;
+		register_append(key, lba, version);
+		if ((int)free_zones.size() < MIN_FREE_ZONES) {
+			notify(cleaning_needed);
+		}
+	}
+}
+
+// A key that is overwritten while it is being moved keeps its new location, since the append of the move is then outdated.
+// The keys that are still in the victim when it is reset are being overwritten, and get their location once the write completes.
+Coroutine_Thread::Client Zoned_Log_Store::clean() {
+	if (!is_zoned) {
+		co_return;
+	}
+	while (true) {
+		long victim = pick_victim();
+		if ((int)free_zones.size() >= MIN_FREE_ZONES || victim == UNDEFINED) {
+			co_await wait(cleaning_needed);
+			continue;
+		}
+		long first_lba = victim * zone_size;
+		for (long lba = first_lba; lba < first_lba + zone_size; lba++) {
+			long key = lba_keys[lba];
+			if (key == UNDEFINED || key_locations[key] != lba) {
+				continue;
+			}
+			co_await read(lba);
+			if (key_locations[key] != lba) {
+				continue;
+			}
+			long version = key_versions[key];
+			long new_lba = co_await zone_append(take_append_slot(cleaning_zone));
+			num_appends++;
+			register_append(key, new_lba, version);
+		}
+		for (long lba = first_lba; lba < first_lba + zone_size; lba++) {
+			long key = lba_keys[lba];
+			if (key != UNDEFINED && key_locations[key] == lba) {
+				key_locations[key] = UNDEFINED;
+			}
+			lba_keys[lba] = UNDEFINED;
+		}
+		num_valid_keys[victim] = 0;
+		num_appends_issued[victim] = 0;
+		num_appends_completed[victim] = 0;
+		co_await reset_zone(first_lba);
+		free_zones.push_back(victim);
+		num_zones_cleaned++;
+		notify(zone_freed);
+	}
+}
+
+// Returns the LBA of the zone to append to, and moves on to a free zone once every page of the current one has been appended to
+long Zoned_Log_Store::take_append_slot(long& zone) {
+	if (zone == UNDEFINED || num_appends_issued[zone] == zone_size) {
+		assert(!free_zones.empty());
+		zone = free_zones.front();
+		free_zones.pop_front();
+	}
+	num_appends_issued[zone]++;
+	return zone * zone_size;
+}
+
+void Zoned_Log_Store::register_append(long key, long lba, long version) {
+	long zone = lba / zone_size;
+	num_appends_completed[zone]++;
+	lba_keys[lba] = key;
+	if (version != key_versions[key]) {
+		return;
+	}
+	if (key_locations[key] != UNDEFINED) {
+		num_valid_keys[key_locations[key] / zone_size]--;
+	}
+	key_locations[key] = lba;
+	num_valid_keys[zone]++;
+}
+
+// The victim is the full zone with the fewest valid keys, among those whose appends have all completed
+long Zoned_Log_Store::pick_victim() const {
+	long victim = UNDEFINED;
+	for (long zone = 0; zone < num_zones; zone++) {
+		bool is_candidate = zone != write_zone && zone != cleaning_zone && num_appends_completed[zone] == zone_size;
+		if (is_candidate && num_valid_keys[zone] < zone_size && (victim == UNDEFINED || num_valid_keys[zone] < num_valid_keys[victim])) {
+			victim = zone;
+		}
+	}
+	return victim;
+}
+
+void Zoned_Log_Store::print(FILE* stream) const {
+	fprintf(stream, "Zoned log store:\t%ld keys written, %ld appends, %ld zones cleaned, host write amplification %f\n",
+			num_key_writes, num_appends, num_zones_cleaned, get_write_amplification());
+}
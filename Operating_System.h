@@ -36,6 +36,10 @@ public:
 	inline void add_follow_up_thread(Thread* thread) { threads_to_start_when_this_thread_finishes.push_back(thread); }
 	inline void add_follow_up_threads(vector<Thread*> threads) { threads_to_start_when_this_thread_finishes.insert(threads_to_start_when_this_thread_finishes.end(), threads.begin(), threads.end()); }
 	inline vector<Thread*>& get_follow_up_threads() { return threads_to_start_when_this_thread_finishes; }
+	inline void set_io_weight(int weight) { io_weight = weight; }
+	inline int get_io_weight() const { return io_weight; }
+	inline void set_latency_target(double target) { latency_target = target; }
+	inline double get_latency_target() const { return latency_target; }
 	StatisticsGatherer* get_internal_statistics_gatherer() { return internal_statistics_gatherer; }
 	StatisticsGatherer* get_external_statistics_gatherer() { return external_statistics_gatherer; }
 	void set_statistics_gatherer(StatisticsGatherer* new_statistics_gatherer);
@@ -61,9 +65,11 @@ private:
 	StatisticsGatherer* internal_statistics_gatherer;
 	StatisticsGatherer* external_statistics_gatherer;
 	int num_IOs_executing;
-	queue<Event*> io_queue;
+	multimap<double, Event*> io_queue;  // keyed by start time, so an IO issued for a later time does not hold back earlier IOs
 	bool finished;
 	bool stopped;
+	int io_weight;          // relative share of the device used by weighted schedulers
+	double latency_target;  // in microseconds. UNDEFINED means the thread has no latency target
 	static bool record_internal_statistics;
 };
 
@@ -141,7 +147,7 @@ public:
 	IO_Pattern() : min_LBA(0), max_LBA(0) {}
 	IO_Pattern(long min_LBA, long max_LBA) : min_LBA(min_LBA), max_LBA(max_LBA) {};
 	virtual ~IO_Pattern() {};
-	virtual int next() = 0;
+	virtual long next() = 0;
 	long min_LBA, max_LBA;
     friend class boost::serialization::access;
     template<class Archive>
@@ -158,7 +164,7 @@ public:
 	Random_IO_Pattern() : IO_Pattern(), random_number_generator(23623620) {}
 	Random_IO_Pattern(long min_LBA, long max_LBA, ulong seed) : IO_Pattern(min_LBA, max_LBA), random_number_generator(seed) {};
 	~Random_IO_Pattern() {};
-	int next() { return min_LBA + random_number_generator() % (max_LBA - min_LBA + 1); };
+	long next() { return min_LBA + random_number_generator.below(max_LBA - min_LBA + 1); };
     friend class boost::serialization::access;
     template<class Archive>
     void serialize(Archive & ar, const unsigned int version) {
@@ -169,25 +175,34 @@ private:
 	MTRand_int32 random_number_generator;
 };
 
-// Creates a uniformly randomly distributed IO pattern acress the target logical address space
+// Visits every address in [min_LBA, max_LBA) exactly once in a random order before starting a new random pass.
+// The order is a keyed Feistel permutation with cycle walking, so it needs no per-address state.
 class Random_IO_Pattern_Collision_Free : public IO_Pattern
 {
 public:
-	Random_IO_Pattern_Collision_Free() : IO_Pattern(), random_number_generator(23623620), counter(0) {}
+	Random_IO_Pattern_Collision_Free() : IO_Pattern(), random_number_generator(23623620), counter(0), half_bits(0), half_mask(0), keys() {}
 	Random_IO_Pattern_Collision_Free(long min_LBA, long max_LBA, ulong seed);
 	~Random_IO_Pattern_Collision_Free() {};
 	void reinit();
-	int next();
+	long next();
     friend class boost::serialization::access;
     template<class Archive>
     void serialize(Archive & ar, const unsigned int version) {
     	ar & boost::serialization::base_object<IO_Pattern>(*this);
     	ar & random_number_generator;
+    	ar & counter;
+    	ar & half_bits;
+    	ar & half_mask;
+    	ar & keys;
     }
 private:
+	ulong permute(ulong index) const;
+	static const int NUM_FEISTEL_ROUNDS = 4;
 	MTRand_int32 random_number_generator;
-	vector<int> candidates;
-	int counter;
+	long counter;
+	uint half_bits;
+	ulong half_mask;
+	vector<ulong> keys;
 };
 
 // Creates a uniformly randomly distributed IO pattern acress the target logical address space
@@ -197,7 +212,7 @@ public:
 	Sequential_IO_Pattern() : IO_Pattern(), counter(0) {}
 	Sequential_IO_Pattern(long min_LBA, long max_LBA) : IO_Pattern(min_LBA, max_LBA), counter(min_LBA - 1) {};
 	~Sequential_IO_Pattern() {};
-	int next() { return counter == max_LBA ? counter = min_LBA : ++counter; };
+	long next() { return counter == max_LBA ? counter = min_LBA : ++counter; };
     friend class boost::serialization::access;
     template<class Archive>
     void serialize(Archive & ar, const unsigned int version) {
@@ -208,6 +223,50 @@ private:
 	long counter;
 };
 
+// Picks addresses with zipf distributed popularity, like fio's random_distribution=zipf:theta.
+// The popularity ranks are scattered across the range by a hash, so hot addresses are not clustered at its start.
+class Zipf_IO_Pattern : public IO_Pattern
+{
+public:
+	Zipf_IO_Pattern() : IO_Pattern(), random_number_generator(23623620), theta(0), zeta_2(0), zeta_n(0) {}
+	Zipf_IO_Pattern(long min_LBA, long max_LBA, double theta, ulong seed);
+	~Zipf_IO_Pattern() {};
+	long next();
+    friend class boost::serialization::access;
+    template<class Archive>
+    void serialize(Archive & ar, const unsigned int version) {
+    	ar & boost::serialization::base_object<IO_Pattern>(*this);
+    	ar & random_number_generator;
+    	ar & theta;
+    	ar & zeta_2;
+    	ar & zeta_n;
+    }
+private:
+	static const long MAX_ZETA_TERMS = 10000000;  // like fio, the zeta constant is only summed over this many ranks
+	MTRand_open random_number_generator;
+	double theta, zeta_2, zeta_n;
+};
+
+// Picks addresses with pareto distributed popularity, like fio's random_distribution=pareto:h
+class Pareto_IO_Pattern : public IO_Pattern
+{
+public:
+	Pareto_IO_Pattern() : IO_Pattern(), random_number_generator(23623620), power(1) {}
+	Pareto_IO_Pattern(long min_LBA, long max_LBA, double h, ulong seed);
+	~Pareto_IO_Pattern() {};
+	long next();
+    friend class boost::serialization::access;
+    template<class Archive>
+    void serialize(Archive & ar, const unsigned int version) {
+    	ar & boost::serialization::base_object<IO_Pattern>(*this);
+    	ar & random_number_generator;
+    	ar & power;
+    }
+private:
+	MTRand_open random_number_generator;
+	double power;
+};
+
 class File_Reading_Thread : public Thread {
 public:
 	File_Reading_Thread();
@@ -386,6 +445,79 @@ public:
 };
 
 
+// Simulates the fuzzy checkpoints of a database buffer pool. Database pages of 8 to 16KB are dirtied at random at
+// dirty_page_rate pages per second. Every checkpoint_interval microseconds, the flash pages dirtied since the last
+// checkpoint are written back in LBA order, with up to max_outstanding_writes in flight.
+// A checkpoint that takes longer than the interval delays the next one.
+class Checkpoint_Thread : public Thread
+{
+public:
+	Checkpoint_Thread(long min_LBA, long max_LBA, double dirty_page_rate, double checkpoint_interval, ulong randseed, int max_outstanding_writes = MAX_SSD_QUEUE_SIZE);
+	void issue_first_IOs();
+	void handle_event_completion(Event* event);
+private:
+	void start_checkpoint(double time);
+	void issue_writes(double time);
+	static const int MIN_DATABASE_PAGE_SIZE = 8192;   // in bytes
+	static const int MAX_DATABASE_PAGE_SIZE = 16384;
+	long min_LBA, max_LBA;
+	double dirty_page_rate, checkpoint_interval, last_checkpoint_time;
+	int max_outstanding_writes;
+	set<long> dirty_pages;
+	MTRand_int32 random_number_generator;
+};
+
+// Latencies and volumes of the IOs of one fio job, or of all its clones with group_reporting
+class Fio_Job_Statistics
+{
+public:
+	Fio_Job_Statistics(string name);
+	void register_io(event_type type, int num_pages, double start_time, double submission_time, double completion_time);
+	void print_json(FILE* stream, map<string, string> const& options) const;
+private:
+	struct Direction {
+		Direction() : num_IOs(0), num_pages(0), completion_latencies(), total_latencies() {}
+		long num_IOs, num_pages;
+		vector<double> completion_latencies;  // from the first page's submission to the SSD until the last page completes
+		vector<double> total_latencies;       // including the time spent queued in the OS
+	};
+	void print_direction_json(FILE* stream, string name, Direction const& direction) const;
+	static void print_latency_json(FILE* stream, string name, vector<double> latencies, bool print_percentiles, bool is_last);
+	string name;
+	Direction reads, writes, trims;
+	double start_time, end_time;
+};
+
+// Runs one clone of a fio job. Each IO covers block_size consecutive pages, and completes once all of them have completed.
+// The block_pattern picks block indexes within the job's region, and the type_generator picks whether to read, write or trim.
+// The job stops after num_IOs IOs or after runtime microseconds, whichever comes first. A rate_iops of UNDEFINED is unthrottled.
+class Fio_Thread : public Thread
+{
+public:
+	Fio_Thread(IO_Pattern* block_pattern, IO_Mode_Generator* type_generator, long first_LBA, int block_size, int iodepth,
+			long num_IOs, double runtime, double rate_iops, Fio_Job_Statistics* statistics);
+	~Fio_Thread();
+	void issue_first_IOs();
+	void handle_event_completion(Event* event);
+private:
+	struct Fio_IO {
+		event_type type;
+		int num_pages_left;
+		double start_time, submission_time;
+	};
+	void generate_io();
+	IO_Pattern* block_pattern;
+	IO_Mode_Generator* type_generator;
+	long first_LBA;
+	int block_size, iodepth;
+	long num_IOs_left;
+	double end_time, rate_iops, next_io_time;
+	int next_io_id;
+	map<int, Fio_IO> ongoing_IOs;
+	unordered_map<uint, int> io_of_page;  // maps the application IO id of each page to its fio IO
+	Fio_Job_Statistics* statistics;
+};
+
 // This thread simulates the IO pattern of an external sort algorithm
 class External_Sort : public Thread
 {
@@ -447,14 +579,14 @@ private:
 	MTRand_int32 random_number_generator;
 	enum {BUILD, PROBE_SYNCH, PROBE_ASYNCH, DONE} phase;
 	vector<int> output_buffers;
-	vector<int> output_cursors;
-	vector<int> output_cursors_startpoints;
-	vector<int> output_cursors_splitpoints; // Separates relation A and B in output buffers
+	vector<long> output_cursors;
+	vector<long> output_cursors_startpoints;
+	vector<long> output_cursors_splitpoints; // Separates relation A and B in output buffers
 	int victim_buffer;
 	int writes_in_progress, reads_in_progress;
 	set<long> reads_in_progress_set;
-	int small_bucket_begin, small_bucket_end;
-	int large_bucket_begin, large_bucket_cursor, large_bucket_end;
+	long small_bucket_begin, small_bucket_end;
+	long large_bucket_begin, large_bucket_cursor, large_bucket_end;
 	bool finished_reading_smaller_bucket, finished_trimming_smaller_bucket;
 
 };
@@ -629,17 +761,309 @@ private:
 	Flexible_Reader* flex_reader;
 };
 
+// A thread whose IO pattern is written as coroutines, one per simulated client, instead of as a state machine driven by IO completions.
+// A client suspends on co_await read(lba) or co_await write_batch(range), and is resumed once all the IOs it awaits have completed.
+// Clients are stackless coroutines whose frames only hold their local variables, so one thread can simulate tens of thousands of clients.
+// Clients can also wait for a condition, such as work becoming available, until another client notifies it.
+// The thread finishes once all its clients have returned and their IOs have completed.
+class Coroutine_Thread : public Thread
+{
+public:
+	struct Client {
+		struct promise_type {
+			promise_type() : num_pending_ios(0), last_completed_lba(UNDEFINED) {}
+			Client get_return_object() { return Client(coroutine_handle<promise_type>::from_promise(*this)); }
+			suspend_always initial_suspend() noexcept { return suspend_always(); }
+			suspend_always final_suspend() noexcept { return suspend_always(); }
+			void return_void() {}
+			void unhandled_exception() { throw; }
+			int num_pending_ios;
+			long last_completed_lba;
+		};
+		explicit Client(coroutine_handle<promise_type> handle) : handle(handle) {}
+		coroutine_handle<promise_type> handle;
+	};
+	// co_await returns the logical address of the IO that completed last, which for a zone append is the one it was assigned
+	struct IO_Awaiter {
+		IO_Awaiter(Coroutine_Thread* thread, vector<Event*> const& events) : thread(thread), events(events), client() {}
+		bool await_ready() const noexcept { return events.empty(); }
+		void await_suspend(coroutine_handle<Client::promise_type> client);
+		long await_resume() const noexcept { return client ? client.promise().last_completed_lba : UNDEFINED; }
+		Coroutine_Thread* thread;
+		vector<Event*> events;
+		coroutine_handle<Client::promise_type> client;
+	};
+	struct Condition {
+		Condition() : waiting_clients() {}
+		vector<coroutine_handle<Client::promise_type> > waiting_clients;
+	};
+	struct Condition_Awaiter {
+		Condition_Awaiter(Condition& condition) : condition(condition) {}
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(coroutine_handle<Client::promise_type> client) { condition.waiting_clients.push_back(client); }
+		void await_resume() const noexcept {}
+		Condition& condition;
+	};
+	Coroutine_Thread(int num_clients);
+	virtual ~Coroutine_Thread();
+	inline int get_num_clients() const { return num_clients; }
+protected:
+	virtual Client run_client(int client_id) = 0;
+	// IOs are issued at the current time, or at start_time if it is later. Writes with a tag carry the size of the range as a hint.
+	IO_Awaiter read(long lba) { return create_awaiter(READ, Address_Range(lba, lba)); }
+	IO_Awaiter write(long lba, int tag = UNDEFINED, double start_time = UNDEFINED) { return create_awaiter(WRITE, Address_Range(lba, lba), tag, start_time); }
+	IO_Awaiter trim(long lba) { return create_awaiter(TRIM, Address_Range(lba, lba)); }
+	IO_Awaiter read_batch(Address_Range range) { return create_awaiter(READ, range); }
+	IO_Awaiter write_batch(Address_Range range, int tag = UNDEFINED, double start_time = UNDEFINED) { return create_awaiter(WRITE, range, tag, start_time); }
+	IO_Awaiter trim_batch(Address_Range range) { return create_awaiter(TRIM, range); }
+	IO_Awaiter fsync() { return IO_Awaiter(this, vector<Event*>(1, new Event(FSYNC, 0, 1, get_current_time()))); }
+	// Zone commands, for zoned devices. See ZNS_FTL.
+	IO_Awaiter zone_append(long zone_lba) { return create_zone_command(WRITE, ZONE_APPEND, zone_lba); }
+	IO_Awaiter reset_zone(long zone_lba) { return create_zone_command(TRIM, ZONE_RESET, zone_lba); }
+	IO_Awaiter finish_zone(long zone_lba) { return create_zone_command(TRIM, ZONE_FINISH, zone_lba); }
+	Condition_Awaiter wait(Condition& condition) { return Condition_Awaiter(condition); }
+	void notify(Condition& condition);
+	void issue_first_IOs();
+	void handle_event_completion(Event* event);
+private:
+	IO_Awaiter create_awaiter(event_type type, Address_Range range, int tag = UNDEFINED, double start_time = UNDEFINED);
+	IO_Awaiter create_zone_command(event_type type, zone_command command, long zone_lba);
+	int num_clients;
+	vector<coroutine_handle<Client::promise_type> > clients;
+	unordered_map<uint, coroutine_handle<Client::promise_type> > waiting_clients;  // keyed by application IO ID
+};
+
+// Clients that each update random pages with a synchronous read followed by a write, like the workers of a database
+class Random_Read_Modify_Write_Clients : public Coroutine_Thread
+{
+public:
+	Random_Read_Modify_Write_Clients(long min_LBA, long max_LBA, int num_clients, ulong randseed);
+protected:
+	Client run_client(int client_id);
+private:
+	long min_LBA, max_LBA;
+	MTRand_int32 random_number_generator;
+};
+
+// Simulates the IO pattern of a key-value store based on a log-structured merge tree with leveled compaction, like RocksDB.
+// The first client appends to a write-ahead log one synchronous page at a time, at up to write_rate pages per second.
+// Once a memtable worth of file_size pages has been logged, the second client flushes it into a new level 0 file and trims its log segment.
+// The remaining clients compact files. Once there are enough level 0 files, they are merged with the level 1 files.
+// Otherwise, a file from the level that most exceeds its target size is merged with the overlapping files in the next level.
+// A compaction reads its N input files, writes its M output files as the merge progresses, and then trims the input files.
+// Merges never hold more keys than the dataset, so compactions into the last level drop overwritten data.
+// Each file occupies a contiguous slot of file_size pages and is written with its own tag. The log has tag 0.
+class LSM_Tree : public Coroutine_Thread
+{
+public:
+	LSM_Tree(long min_LBA, long max_LBA, int file_size, int level_fanout, double write_rate, int num_compaction_clients = 1);
+	~LSM_Tree();
+protected:
+	Client run_client(int client_id);
+private:
+	struct File {
+		File(int id, long slot, long size, double min_key, double max_key)
+			: id(id), slot(slot), size(size), min_key(min_key), max_key(max_key), is_being_compacted(false) {}
+		int id;
+		long slot;
+		long size;                // in pages
+		double min_key, max_key;  // the file holds keys in [min_key, max_key) out of [0, 1)
+		bool is_being_compacted;
+	};
+	struct Compaction {
+		Compaction() : level(UNDEFINED), inputs() {}
+		int level;  // the outputs go to the next level
+		vector<File*> inputs;
+	};
+	Client write_log();
+	Client flush_memtables();
+	Client compact();
+	Compaction pick_compaction();
+	void install_compaction(Compaction const& compaction, vector<File*> const& outputs);
+	File* create_file(long size, double min_key, double max_key);
+	void delete_file(File* file);
+	vector<File*> get_overlapping_files(int level, double min_key, double max_key) const;
+	long get_level_size(int level) const;
+	long get_target_size(int level) const;
+	inline Address_Range get_range(File const* file) const { return Address_Range(first_file_LBA + file->slot * file_size, first_file_LBA + file->slot * file_size + file->size - 1); }
+	inline bool can_write() const { return num_immutable_memtables < MAX_IMMUTABLE_MEMTABLES && (int)levels[0].size() < LEVEL_0_STOP_WRITES_TRIGGER; }
+
+	static const int MAX_IMMUTABLE_MEMTABLES = 2;
+	static const int LEVEL_0_COMPACTION_TRIGGER = 4;
+	static const int LEVEL_0_STOP_WRITES_TRIGGER = 12;
+	static const int LOG_TAG = 0;
+	static const double DATASET_FRACTION;  // of the space for files
+
+	long min_LBA, max_LBA, first_file_LBA;
+	int file_size, level_fanout;
+	double write_rate, next_write_time;
+	long log_size, log_cursor;
+	int num_memtable_pages, num_immutable_memtables, num_flushed_memtables;
+	long dataset_size;
+	vector<vector<File*> > levels;     // levels 1 and deeper are sorted by key and their files do not overlap
+	vector<double> compaction_cursors; // the key each level resumes picking compaction inputs from
+	set<long> free_slots;
+	unordered_map<int, File*> files;
+	int file_id_generator;
+	Condition memtable_full, writes_can_resume, compaction_possible, slot_freed;
+};
+
+// Simulates a log-structured store that places its data itself on a zoned device (see ZNS_FTL), with keys that take one page each.
+// The clients overwrite random keys by appending them to the open zone, and keep track of the LBAs the appends were assigned.
+// Once fewer than MIN_FREE_ZONES zones are empty, the cleaner picks the full zone with the fewest valid keys, reads them,
+// appends them to its own open zone, and resets the zone. The host write amplification is the number of appends per key written.
+// On a conventional device, each key is written in place at its own LBA instead, so the device does the garbage collection.
+class Zoned_Log_Store : public Coroutine_Thread
+{
+public:
+	Zoned_Log_Store(long num_keys, int num_clients, ulong randseed);
+	inline double get_write_amplification() const { return num_appends / (double)max(1L, num_key_writes); }
+	void print(FILE* stream = stdout) const;
+protected:
+	void issue_first_IOs();
+	Client run_client(int client_id);
+private:
+	Client write_keys();
+	Client clean();
+	long take_append_slot(long& zone);
+	void register_append(long key, long lba, long version);
+	long pick_victim() const;
+	inline bool can_open_zone_for_writes() const { return (int)free_zones.size() > RESERVED_ZONES; }
+	static const int MIN_FREE_ZONES = 3;
+	static const int RESERVED_ZONES = 1;  // kept for the cleaner, so it can always move the valid keys out of its victim
+	long num_keys, zone_size, num_zones;
+	bool is_zoned;
+	vector<long> key_locations;   // the LBA of each key, or UNDEFINED
+	vector<long> key_versions;    // incremented with every write, so appends that complete after a later one are ignored
+	vector<long> lba_keys;        // the key that was last appended at each LBA
+	vector<long> num_valid_keys, num_appends_issued, num_appends_completed;  // per zone
+	deque<long> free_zones;
+	long write_zone, cleaning_zone;  // the zones being appended to, or UNDEFINED
+	long num_key_writes, num_appends, num_zones_cleaned;
+	MTRand_int32 random_number_generator;
+	Condition cleaning_needed, zone_freed;
+};
+
+// The measurements of one test of the SNIA Solid State Storage Performance Test Specification (PTS).
+// A test runs its points, which are combinations of block sizes and read/write mixes, one after the other in rounds.
+// Steady state is reached once the tracking variable of the last WINDOW_SIZE rounds stays within MAX_DATA_EXCURSION of its average,
+// and the best linear fit through it changes by at most MAX_SLOPE_EXCURSION of the average across the window.
+// The tracking variable is the 4KiB random write IOPS for the IOPS test, the 1024KiB sequential write throughput for the
+// throughput test, and the 4KiB random write mean latency for the latency test. The results are averaged over the window.
+class SNIA_PTS_Results
+{
+public:
+	struct Point {
+		Point(int block_size, double read_fraction, bool is_sequential) : block_size(block_size), read_fraction(read_fraction), is_sequential(is_sequential) {}
+		int block_size;  // in pages
+		double read_fraction;
+		bool is_sequential;
+	};
+	SNIA_PTS_Results(pts_test test);
+	static string get_test_name(pts_test test);
+	inline pts_test get_test() const { return test; }
+	inline vector<Point> const& get_points() const { return points; }
+	void register_io(int point, double latency);
+	void end_point(int point, double duration);
+	inline bool is_finished() const { return finished; }
+	void print_csv(FILE* stream) const;
+	void print_iops_matrix_csv(FILE* stream) const;
+	void print_steady_state_csv(FILE* stream) const;
+	static const int WINDOW_SIZE = 5;
+	static const int MAX_ROUNDS = 25;
+	static const double MAX_DATA_EXCURSION, MAX_SLOPE_EXCURSION;
+private:
+	struct Measurement {
+		Measurement() : duration(0), latencies() {}
+		double duration;
+		vector<double> latencies;
+	};
+	struct Summary {
+		double iops, throughput, mean_latency, percentile_latency, max_latency;  // throughput in MB/s, latencies in microseconds
+	};
+	void check_steady_state();
+	Summary summarize(int point, int first_round, int last_round) const;
+	double get_tracking_value(int round) const;
+	static string get_mix_name(double read_fraction);
+	inline int get_last_round() const { return finished ? rounds.size() - 1 : rounds.size() - 2; }  // the last complete round
+	pts_test test;
+	vector<Point> points;
+	int tracked_point;
+	vector<vector<Measurement> > rounds;  // the last round is the one in progress
+	int steady_state_round;               // the last round of the window in which steady state was reached
+	bool finished;
+};
+
+// Runs one SNIA PTS test over the logical address space with queue_depth clients that each have one IO outstanding.
+// As workload independent preconditioning, twice the capacity is first written sequentially in 128KiB IOs.
+// The rounds of the test then serve as workload dependent preconditioning. Each point runs for point_duration microseconds,
+// after which the clients wait for each other's last IO before the next point starts.
+class SNIA_PTS_Thread : public Coroutine_Thread
+{
+public:
+	SNIA_PTS_Thread(long min_LBA, long max_LBA, SNIA_PTS_Results* results, int queue_depth, double point_duration, ulong randseed);
+protected:
+	Client run_client(int client_id);
+private:
+	Address_Range next_range(SNIA_PTS_Results::Point const& point);
+	void start_next_point();
+	static const int PRECONDITION_BLOCK_SIZE_IN_KB = 128;
+	long min_LBA, max_LBA;
+	SNIA_PTS_Results* results;
+	double point_duration;
+	long num_precondition_IOs_left, sequential_cursor;
+	int current_point, num_clients_done;
+	double point_start_time, point_end_time;
+	MTRand_int32 random_number_generator;
+	Condition point_started;
+};
+
+// An indexed binary min-heap of thread IDs. Keys can be changed or removed in O(log n) by thread ID.
+// Ties are broken by the lower thread ID, so the order is deterministic.
+class Thread_Priority_Queue {
+public:
+	void update(int thread_id, double key);
+	void remove(int thread_id);
+	inline bool contains(int thread_id) const { return positions.count(thread_id) == 1; }
+	inline bool empty() const { return heap.empty(); }
+	inline uint size() const { return heap.size(); }
+	inline int top() const { return heap.front().second; }
+	inline double top_key() const { return heap.front().first; }
+	inline double get_key(int thread_id) const { return heap[positions.at(thread_id)].first; }
+	void clear();
+private:
+	void sift_up(uint index);
+	void sift_down(uint index);
+	void swap_nodes(uint a, uint b);
+	vector<pair<double, int> > heap;
+	unordered_map<int, uint> positions; // maps a thread ID to its index in the heap
+};
+
 // This class can be extended to allow customized IO scheduling policies
+// The operating system calls register_thread_update whenever the IO at the head of a thread's queue may have changed.
+// Schedulers can use this to index threads instead of scanning all of them on every pick.
 class OS_Scheduler {
 public:
+	OS_Scheduler() : time(0) {}
 	virtual ~OS_Scheduler() {}
 	virtual int pick(unordered_map<int, Thread*> const& threads) = 0;
+	virtual void register_thread_update(int thread_id, Thread* thread) {}
+	virtual void register_thread_removal(int thread_id) {}
+	virtual void register_dispatch(int thread_id, Thread* thread, Event const& event) {}
+	inline void set_time(double current_time) { time = current_time; }
+protected:
+	double time;
 };
 
 // This is a FIFO scheduler that implements a simple IO queue.
+// Threads are indexed by the time of their next IO, so picking is O(log n) in the number of threads.
 class FIFO_OS_Scheduler : public OS_Scheduler {
 public:
 	int pick(unordered_map<int, Thread*> const& threads);
+	void register_thread_update(int thread_id, Thread* thread);
+	void register_thread_removal(int thread_id);
+private:
+	Thread_Priority_Queue next_io_times;
 };
 
 // This is a fair IO scheduler that tries to schedule IOs from different threads in round robin
@@ -651,6 +1075,95 @@ private:
 	int last_id;
 };
 
+// A weighted fair IO scheduler in the spirit of the cgroup io.weight controller and BFQ.
+// Each thread receives a share of the dispatched pages proportional to its IO weight.
+// This is tracked with start-time fair queueing over the IOs whose arrival time has been reached.
+// A thread with a latency target has its next IO dispatched first once that IO has waited beyond the target.
+class Weighted_Fair_OS_Scheduler : public OS_Scheduler {
+public:
+	Weighted_Fair_OS_Scheduler() : OS_Scheduler(), virtual_time(0) {}
+	int pick(unordered_map<int, Thread*> const& threads);
+	void register_thread_update(int thread_id, Thread* thread);
+	void register_thread_removal(int thread_id);
+	void register_dispatch(int thread_id, Thread* thread, Event const& event);
+	static const int DEFAULT_IO_WEIGHT = 100;
+private:
+	void make_eligible(int thread_id, Thread* thread);
+	Thread_Priority_Queue arrival_times;       // backlogged threads whose next IO has not arrived yet, keyed by its arrival time
+	Thread_Priority_Queue virtual_start_tags;  // threads whose next IO has arrived, keyed by virtual start tag
+	Thread_Priority_Queue deadlines;           // threads whose next IO has arrived and that have a latency target, keyed by deadline
+	unordered_map<int, double> virtual_finish_tags;
+	double virtual_time;
+};
+
+// A host page cache in front of the SSD, in the spirit of the Linux page cache.
+// Reads that hit complete at memory latency, and sequential reads trigger readahead with a window that doubles up to PAGE_CACHE_READAHEAD_MAX pages.
+// Writes are buffered as dirty pages and complete at memory latency. Once more than PAGE_CACHE_DIRTY_BACKGROUND_RATIO of the cache is dirty,
+// dirty pages are written back in batches sorted by logical address. Writers are throttled once more than PAGE_CACHE_DIRTY_RATIO of the cache is dirty.
+// An FSYNC event is a barrier that completes once all pages that were dirty when it arrived have been written back.
+// Like a truncate, a trim to pages with writeback or readahead IOs executing is held back until those IOs are done.
+// Writeback and readahead IOs are submitted by the OS on behalf of the kernel, and are not counted as application IOs.
+class Page_Cache {
+public:
+	Page_Cache(OperatingSystem* os, long capacity);
+	bool absorb(Event* event, int thread_id);
+	void register_read_completion(Event const& event);
+	void register_kernel_io_completion(Event const& event);
+	bool has_blocked_ios() const;
+	void print_stats() const;
+private:
+	struct cached_page {
+		cached_page() : dirty(false), under_writeback(false), reading(false), lru_position() {}
+		bool dirty;            // modified since the page was last written back
+		bool under_writeback;  // a writeback of the page is executing in the SSD
+		bool reading;          // the page is being read ahead, and its data has not arrived yet
+		list<long>::iterator lru_position;
+	};
+	struct readahead_state {
+		readahead_state() : next_lba(UNDEFINED), window(0), readahead_end(UNDEFINED) {}
+		long next_lba;       // the logical address a sequential read by the thread would start at
+		long window;         // the current readahead window in pages
+		long readahead_end;  // the last logical address read ahead so far
+	};
+	struct blocked_io {
+		blocked_io(Event* event, int thread_id) : event(event), thread_id(thread_id), pending() {}
+		Event* event;
+		int thread_id;
+		unordered_set<long> pending;  // the logical addresses whose IOs the blocked IO waits for
+	};
+	bool absorb_read(Event* event, int thread_id);
+	void absorb_write(Event* event, int thread_id);
+	void absorb_fsync(Event* event, int thread_id);
+	bool absorb_trim(Event* event, int thread_id);
+	void invalidate(Event const& event);
+	cached_page& insert(long lba);
+	void evict();
+	void read_ahead(Event const& event, int thread_id);
+	void write_back(double time);
+	void release_throttled_writes(double time);
+	void release_barriers(long lba, double time);
+	void release_trims(long lba, double time);
+	void complete(Event* event, int thread_id, double time);
+	inline bool is_over_dirty_limit() const { return (long)(dirty_pages.size() + pages_under_writeback.size()) > dirty_limit; }
+
+	OperatingSystem* os;
+	long capacity;
+	long dirty_limit;
+	long background_dirty_limit;
+	unordered_map<long, cached_page> pages;
+	list<long> lru;                // the cached logical addresses, most recently used first
+	set<long> dirty_pages;         // sorted, so that writeback sweeps the logical address space like an elevator
+	unordered_set<long> pages_under_writeback;
+	long writeback_cursor;
+	unordered_map<int, readahead_state> readahead;  // keyed by thread ID
+	unordered_map<long, vector<pair<Event*, int> > > reads_waiting_for_readahead;
+	unordered_set<long> trimmed_pages;  // the last IO to these pages that was sent to the SSD is a trim, so the SSD holds no data for them
+	deque<pair<Event*, int> > throttled_writes;
+	list<blocked_io> fsync_barriers;
+	list<blocked_io> deferred_trims;
+	long num_read_hits, num_read_misses, num_readahead_pages, num_writeback_pages, num_throttled_writes, num_fsyncs;
+};
+
 class OperatingSystem
 {
 public:
@@ -660,14 +1173,16 @@ public:
 	void init_threads();
 	~OperatingSystem();
 	void run();
-	void check_if_stuck(bool no_pending_event, bool queue_is_full);
 	void print_progess();
 	void register_event_completion(Event* event);
 	void set_num_writes_to_stop_after(long num_writes);
 	void set_progress_meter_granularity(int num) { progress_meter_granularity = num; }
 	Flexible_Reader* create_flexible_reader(vector<Address_Range>);
 	void submit(Event* event);
+	void queue_for_submission(Event* event, int thread_id);
+	void complete_in_memory(Event* event, int thread_id);
 	Ssd* get_ssd() { return ssd; }
+	static const int KERNEL_THREAD_ID = 0;  // IOs submitted by the OS itself, such as writeback and readahead
     friend class boost::serialization::access;
     template<class Archive>
     void serialize(Archive & ar, const unsigned int version)
@@ -676,21 +1191,72 @@ public:
     }
 private:
 	void dispatch_event(int thread_id);
+	void dispatch_queued_io();
+	void complete_memory_io();
+	void complete_event(Event* event, int thread_id);
+	void plug(Event* event, int thread_id);
+	void unplug();
+	void submit_request(Event* event, int thread_id);
+	void report_deadlock(bool queue_is_full) const;
+	bool has_pending_follow_up_threads() const;
+	bool is_switching_simulation_mode();
+	void switch_simulation_mode();
 	double get_event_minimal_completion_time(Event const*const event) const;
 	void setup_follow_up_threads(int thread_id, double time);
+
+	// A fixed-size open addressing table of the IOs currently executing in the SSD, keyed by application IO ID.
+	// It maps each IO to the thread that submitted it, and is sized so that its load factor never exceeds one half.
+	struct outstanding_io_table {
+		outstanding_io_table();
+		void insert(uint application_io_id, int thread_id);
+		int remove(uint application_io_id);
+		inline int size() const { return num_ios; }
+		void print(FILE* stream) const;
+	private:
+		struct slot {
+			slot() : application_io_id(0), thread_id(UNDEFINED) {}
+			uint application_io_id;
+			int thread_id;
+		};
+		inline uint home_slot(uint application_io_id) const { return application_io_id & mask; }
+		vector<slot> slots;
+		uint mask;
+		int num_ios;
+	};
+
+	// IOs held back by the OS so that IOs to adjacent logical addresses can be merged into one request, like in the Linux block layer.
+	// A request is a range of logical addresses of one IO type. New IOs are appended to its back or prepended to its front.
+	struct plugged_request {
+		plugged_request(Event* event, int thread_id);
+		bool can_merge(Event const& event) const;
+		void merge(Event* event, int thread_id);
+		inline long get_size() const { return max_lba - min_lba + 1; }
+		event_type type;
+		long min_lba, max_lba;
+		double earliest_arrival, latest_arrival;
+		vector<pair<Event*, int> > parts; // the merged IOs and the IDs of the threads that submitted them
+	};
+
 	Ssd * ssd;
 	unordered_map<int, Thread*> threads;
 	vector<Thread*> historical_threads;
-	unordered_map<long, long> app_id_to_thread_id_mapping;
-	set<uint> currently_executing_ios;
+	outstanding_io_table outstanding_ios;
+	vector<plugged_request> plugged_requests;
+	unordered_map<uint, vector<pair<Event*, int> > > merged_requests; // maps the application IO ID of a merged request to its parts
+	long num_merged_ios;
+	long num_merged_requests;
+	Page_Cache* page_cache;  // NULL if the page cache is disabled
+	deque<pair<Event*, int> > queued_ios;  // IOs released by the page cache, waiting for room in the SSD queue
+	double last_submission_time;
+	multimap<double, pair<Event*, int> > memory_completions;  // IOs completed without the SSD, keyed by completion time
 	long NUM_WRITES_TO_STOP_AFTER;
 	long num_writes_completed;
 	int counter_for_user;
-	int idle_time;
 	double time;
 	static int thread_id_generator;
 	OS_Scheduler* scheduler;
 	int progress_meter_granularity;
+	bool is_sampling;  // whether the run alternates between functional and timed execution, see Sampled_Simulation
 };
 
 }
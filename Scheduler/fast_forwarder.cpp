@@ -0,0 +1,189 @@
+/*
+ * fast_forwarder.cpp
+ *
+ *  Functional execution of IOs, without the scheduler's timing model, to quickly drive the SSD to steady state.
+ */
+
+#include "../ssd.h"
+
+using namespace ssd;
+
+Fast_Forwarder::Fast_Forwarder(Ssd* ssd, FtlParent* ftl, Block_manager_parent* bm, Migrator* migrator)
+	: ssd(ssd),
+	  ftl(ftl),
+	  bm(bm),
+	  migrator(migrator),
+	  application_events(),
+	  internal_events(),
+	  completed_events(),
+	  die_finish_times(SSD_SIZE, vector<double>(PACKAGE_SIZE, 0)),
+	  num_erases(0)
+{
+	for (uint i = 0; i < SSD_SIZE; i++) {
+		for (uint j = 0; j < PACKAGE_SIZE; j++) {
+			die_finish_times[i][j] = ssd->get_package(i)->get_die(j)->get_currently_executing_io_finish_time();
+		}
+	}
+}
+
+Fast_Forwarder::~Fast_Forwarder() {
+	assert(is_idle());
+	for (uint i = 0; i < SSD_SIZE; i++) {
+		for (uint j = 0; j < PACKAGE_SIZE; j++) {
+			ssd->get_package(i)->get_die(j)->set_currently_executing_io_finish_time(die_finish_times[i][j]);
+		}
+	}
+}
+
+void Fast_Forwarder::schedule_event(Event* event) {
+	if (event->get_event_type() == GARBAGE_COLLECTION || event->get_event_type() == ERASE) {
+		internal_events.push_back(event);
+	} else {
+		application_events.push_back(event);
+	}
+}
+
+// Nothing takes any time, so the next event is always due at the time it was sent
+double Fast_Forwarder::get_next_event_time() const {
+	double next_time = numeric_limits<double>::infinity();
+	if (!application_events.empty()) {
+		next_time = application_events.front()->get_current_time();
+	}
+	if (!completed_events.empty()) {
+		next_time = min(next_time, completed_events.front()->get_current_time());
+	}
+	return next_time;
+}
+
+// Executes the next application IO along with any GC it triggers, and then returns the completed IOs to the OS
+void Fast_Forwarder::execute_soonest_events() {
+	execute_internal_events();
+	if (!application_events.empty()) {
+		Event* event = application_events.front();
+		application_events.pop_front();
+		if (event->get_event_type() == WRITE) {
+			execute_write(event);
+		} else if (event->get_event_type() == READ) {
+			execute_read(event);
+		} else if (event->get_event_type() == TRIM) {
+			execute_trim(event);
+		} else {
+			assert(event->get_event_type() == MESSAGE);
+			bm->receive_message(*event);
+		}
+		completed_events.push_back(event);
+		execute_internal_events();
+	}
+	while (!completed_events.empty()) {
+		Event* event = completed_events.front();
+		completed_events.pop_front();
+		ssd->register_event_completion(event);
+	}
+}
+
+void Fast_Forwarder::execute_internal_events() {
+	while (!internal_events.empty()) {
+		Event* event = internal_events.front();
+		internal_events.pop_front();
+		if (event->get_event_type() == ERASE) {
+			execute_erase(event);
+		} else {
+			execute_garbage_collection(event);
+		}
+		delete event;
+	}
+}
+
+// If there is no free page, the block manager has either asked for GC, or it is asked for here, and the GC is run
+// to completion before trying again. Copy backs are executed as normal GC writes.
+void Fast_Forwarder::execute_write(Event* write) {
+	if (write->get_event_type() == COPY_BACK) {
+		write->set_event_type(WRITE);
+	}
+	bm->register_write_arrival(*write);
+	Address address = bm->choose_write_address(*write);
+	while (address.valid == NONE) {
+		long num_erases_before = num_erases;
+		if (internal_events.empty()) {
+			migrator->schedule_gc(write->get_current_time(), -1, -1, -1, -1);
+		}
+		execute_internal_events();
+		address = bm->choose_write_address(*write);
+		if (address.valid == NONE && num_erases == num_erases_before) {
+			fprintf(stderr, "Fast forward error: no free page could be found or reclaimed for the write: ");
+			write->print(stderr);
+			assert(false);
+		}
+	}
+	write->set_address(address);
+	ftl->set_replace_address(*write);
+	get_block(address)->write(*write);
+	occupy_die(address, PAGE_WRITE_DELAY);
+	ftl->register_write_completion(*write, SUCCESS);
+	bm->register_write_outcome(*write, SUCCESS);
+	migrator->register_event_completion(write);
+}
+
+// Reads do not change the flash state, but a read of an unwritten address is still an error, like in the timed simulation
+void Fast_Forwarder::execute_read(Event* read) {
+	read->set_event_type(READ_TRANSFER);
+	ftl->set_read_address(*read);
+	occupy_die(read->get_address(), PAGE_READ_DELAY);
+	ftl->register_read_completion(*read, SUCCESS);
+	bm->register_read_transfer_outcome(*read, SUCCESS);
+}
+
+void Fast_Forwarder::execute_trim(Event* trim) {
+	ftl->set_replace_address(*trim);
+	if (trim->get_replace_address().valid == NONE) {
+		return;
+	}
+	ftl->register_trim_completion(*trim);
+	bm->trim(*trim);
+	migrator->register_event_completion(trim);
+}
+
+void Fast_Forwarder::execute_erase(Event* erase) {
+	get_block(erase->get_address())->_erase(*erase);
+	occupy_die(erase->get_address(), BLOCK_ERASE_DELAY);
+	num_erases++;
+	bm->register_erase_outcome(*erase, SUCCESS);
+	ftl->register_erase_completion(*erase);
+	migrator->register_event_completion(erase);
+}
+
+// The migrator only returns the first migration of each victim block, and hands out the others as they finish
+void Fast_Forwarder::execute_garbage_collection(Event* gc_event) {
+	vector<deque<Event*> > migrations = migrator->migrate(gc_event);
+	for (auto migration : migrations) {
+		Event victim_read = *migration.front();
+		victim_read.set_address(migration.front()->get_address());
+		execute_migration(migration);
+		while (migrator->more_migrations(&victim_read)) {
+			execute_migration(migrator->trigger_next_migration(&victim_read));
+		}
+	}
+}
+
+// A migration is a read, or a read command for a copy back, followed by the write
+void Fast_Forwarder::execute_migration(deque<Event*> migration) {
+	assert(migration.size() == 2);
+	Event* read = migration.front();
+	Event* write = migration.back();
+	if (read->get_event_type() == READ) {
+		migrator->register_ECC_check_on(read->get_logical_address());
+	}
+	occupy_die(read->get_address(), PAGE_READ_DELAY);
+	execute_write(write);
+	delete read;
+	delete write;
+}
+
+void Fast_Forwarder::occupy_die(Address const& address, double duration) {
+	Die* die = ssd->get_package(address.package)->get_die(address.die);
+	die->set_currently_executing_io_finish_time(die->get_currently_executing_io_finish_time() + duration);
+}
+
+Block* Fast_Forwarder::get_block(Address const& address) {
+	return ssd->get_package(address.package)->get_die(address.die)->get_plane(address.plane)->get_block(address.block);
+}
@@ -26,7 +26,8 @@ IOScheduler::IOScheduler() :
 	dependency_code_to_LBA(),
 	dependency_code_to_type(),
 	safe_cache(0),
-	stats()
+	stats(),
+	fast_forwarder(NULL)
 {
 	READ_TRANSFER_DEADLINE = PAGE_READ_DELAY;
 }
@@ -71,6 +72,7 @@ IOScheduler::~IOScheduler(){
 		entry.second.clear();
 	}
 	dependencies.clear();
+	delete fast_forwarder;
 	delete bm;
 	delete migrator;
 }
@@ -107,11 +109,34 @@ void IOScheduler::schedule_events_queue(deque<Event*> events) {
 
 // TODO: make this not call the schedule_events_queue method, but simply put the event in future events
 void IOScheduler::schedule_event(Event* event) {
+	if (fast_forwarder != NULL) {
+		fast_forwarder->schedule_event(event);
+		return;
+	}
 	deque<Event*> eventVec;
 	eventVec.push_back(event);
 	schedule_events_queue(eventVec);
 }
 
+// Fast forwarding can only start and stop while no events are in flight, since the two modes keep separate queues
+// The fast forwarder only supports page mapping FTLs
+bool IOScheduler::can_fast_forward() const {
+	return dynamic_cast<FtlImpl_Page*>(ftl) != NULL;
+}
+
+void IOScheduler::set_fast_forward(bool fast_forward) {
+	if (fast_forward && fast_forwarder == NULL) {
+		assert(is_idle());
+		fast_forwarder = new Fast_Forwarder(ssd, ftl, bm, migrator);
+	} else if (!fast_forward && fast_forwarder != NULL) {
+		while (!fast_forwarder->is_idle()) {
+			fast_forwarder->execute_soonest_events();
+		}
+		delete fast_forwarder;
+		fast_forwarder = NULL;
+	}
+}
+
 void IOScheduler::send_earliest_completed_events_back() {
 	for (auto event : completed_events->get_soonest_events()) {
 		ssd->register_event_completion(event);
@@ -127,6 +152,10 @@ void IOScheduler::complete(Event* event) {
 }
 
 void IOScheduler::execute_soonest_events() {
+	if (fast_forwarder != NULL) {
+		fast_forwarder->execute_soonest_events();
+		return;
+	}
 	/*if (StatisticsGatherer::get_global_instance()->total_writes() > 1000001) {
 		if (!current_events->empty()) current_events->print();
 		if (!overdue_events->empty()) overdue_events->print();
@@ -162,9 +191,32 @@ void IOScheduler::execute_soonest_events() {
 
 // this is used to signal the SSD object when all events have finished executing
 bool IOScheduler::is_empty() {
+	if (fast_forwarder != NULL) {
+		return fast_forwarder->is_empty();
+	}
 	return current_events->empty() && future_events->empty() && overdue_events->empty();
 }
 
+// unlike is_empty, this also accounts for completed application IOs that are waiting to be sent back to the OS
+bool IOScheduler::is_idle() {
+	if (fast_forwarder != NULL) {
+		return fast_forwarder->is_idle();
+	}
+	return is_empty() && completed_events->empty();
+}
+
+// the time of the next event to execute or to send back to the OS, which is infinite if the SSD is idle
+double IOScheduler::get_next_event_time() {
+	if (fast_forwarder != NULL) {
+		return fast_forwarder->get_next_event_time();
+	}
+	double next_time = is_empty() ? numeric_limits<double>::infinity() : get_current_time();
+	if (!completed_events->empty()) {
+		next_time = min(next_time, completed_events->get_earliest_time());
+	}
+	return next_time;
+}
+
 double IOScheduler::get_soonest_event_time(vector<Event*> const& events) const {
 	double earliest_time = events.front()->get_current_time();
 	for (uint i = 1; i < events.size(); i++) {
@@ -394,10 +446,10 @@ void IOScheduler::handle_write(Event* event) {
 		event->incr_bus_wait_time(BUS_DATA_DELAY + BUS_CTRL_DELAY);  // actually, we never know how long to wait here. Space might clear on any LUN on the SSD any time
 		push(event);
 	}
+	// Block mapping FTLs like FAST choose the address themselves, so the die's register may still hold a read
 	else if (!bm->can_schedule_on_die(addr, event->get_event_type(), event->get_application_io_id())) {
 		event->incr_bus_wait_time(wait_time + BUS_DATA_DELAY + BUS_CTRL_DELAY);
 		push(event);
-		assert(false);
 	}
 	else if (wait_time > 0) {
 		event->incr_bus_wait_time(wait_time);
@@ -426,7 +478,7 @@ void IOScheduler::transform_copyback(Event* event) {
 
 bool IOScheduler::should_event_be_scheduled(Event* event) {
 	remove_redundant_events(event);
-	uint la = event->get_logical_address();
+	ulong la = event->get_logical_address();
 	return LBA_currently_executing.count(la) == 1 && LBA_currently_executing[la] == event->get_application_io_id();
 }
 
@@ -607,10 +659,10 @@ enum status IOScheduler::execute_next(Event* event) {
 	} else {
 		assert(dependencies.count(dependency_code) == 1);
 		dependencies.erase(dependency_code);
-		uint lba = dependency_code_to_LBA[dependency_code];
+		ulong lba = dependency_code_to_LBA[dependency_code];
 		if (event->get_event_type() != ERASE && !event->is_flexible_read()) {
 			if (LBA_currently_executing.count(lba) == 0) {
-				printf("Assertion failure LBA_currently_executing.count(lba = %d) = %d, concerning ", lba, LBA_currently_executing.count(lba));
+				printf("Assertion failure LBA_currently_executing.count(lba = %lu) = %lu, concerning ", lba, LBA_currently_executing.count(lba));
 				event->print();
 			}
 			//assert(LBA_currently_executing.count(lba) == 1);
@@ -807,7 +859,7 @@ void IOScheduler::try_to_put_in_safe_cache(Event* write) {
 void IOScheduler::remove_redundant_events(Event* new_event) {
 
 
-	uint la = new_event->get_logical_address();
+	ulong la = new_event->get_logical_address();
 	if (LBA_currently_executing.count(la) == 0) {
 		LBA_currently_executing[new_event->get_logical_address()] = new_event->get_application_io_id();
 		return;
@@ -817,7 +869,7 @@ void IOScheduler::remove_redundant_events(Event* new_event) {
 	}
 
 	uint dependency_code_of_new_event = new_event->get_application_io_id();
-	uint common_logical_address = new_event->get_logical_address();
+	ulong common_logical_address = new_event->get_logical_address();
 	uint dependency_code_of_other_event = LBA_currently_executing[common_logical_address];
 
 	Event * existing_event = current_events->find(dependency_code_of_other_event);
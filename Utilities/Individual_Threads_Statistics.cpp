@@ -33,6 +33,10 @@ StatisticsGatherer* Individual_Threads_Statistics::get_stats_for_thread(int inde
 	return t->get_internal_statistics_gatherer();
 }
 
+string Individual_Threads_Statistics::get_thread_name(int index) {
+	return thread_names[index];
+}
+
 int Individual_Threads_Statistics::size() {
 	return threads.size();
 }
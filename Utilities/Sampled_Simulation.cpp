@@ -0,0 +1,133 @@
+#include "../ssd.h"
+#include <numeric>
+using namespace ssd;
+
+vector<Sampled_Simulation::Sample> Sampled_Simulation::samples = vector<Sampled_Simulation::Sample>();
+vector<double> Sampled_Simulation::latencies = vector<double>();
+Sampled_Simulation::sampling_phase Sampled_Simulation::phase = Sampled_Simulation::FUNCTIONAL;
+long Sampled_Simulation::num_IOs_in_phase = 0;
+long Sampled_Simulation::num_functional_IOs = 0;
+long Sampled_Simulation::num_detailed_IOs = 0;
+long Sampled_Simulation::period = 0;
+double Sampled_Simulation::sample_start_time = 0;
+
+void Sampled_Simulation::init() {
+	samples.clear();
+	latencies.clear();
+	phase = FUNCTIONAL;
+	num_IOs_in_phase = 0;
+	num_functional_IOs = 0;
+	num_detailed_IOs = 0;
+	period = SAMPLING_PERIOD;
+	sample_start_time = 0;
+}
+
+// The samples of the old workload say nothing about the new one, so sampling starts over with a functional stretch
+void Sampled_Simulation::register_workload_change() {
+	samples.clear();
+	latencies.clear();
+	phase = FUNCTIONAL;
+	num_IOs_in_phase = 0;
+	period = SAMPLING_PERIOD;
+}
+
+// Called by the operating system for every completed application IO, whether it was executed functionally or timed
+void Sampled_Simulation::register_completed_event(Event const& event) {
+	if (SAMPLING_PERIOD <= 0) {
+		return;
+	}
+	num_IOs_in_phase++;
+	if (phase == FUNCTIONAL) {
+		num_functional_IOs++;
+		if (num_IOs_in_phase >= period) {
+			phase = SAMPLING_WARMUP > 0 ? WARMING_UP : MEASURING;
+			num_IOs_in_phase = 0;
+			sample_start_time = event.get_current_time();
+		}
+		return;
+	}
+	num_detailed_IOs++;
+	if (phase == WARMING_UP) {
+		if (num_IOs_in_phase >= SAMPLING_WARMUP) {
+			phase = MEASURING;
+			num_IOs_in_phase = 0;
+			sample_start_time = event.get_current_time();
+		}
+		return;
+	}
+	latencies.push_back(event.get_latency());
+	if (num_IOs_in_phase >= max(1, SAMPLING_WINDOW)) {
+		end_sample(event.get_current_time());
+	}
+}
+
+// Once there are enough samples, the period grows while the estimates are precise enough, so fewer IOs are timed
+void Sampled_Simulation::end_sample(double time) {
+	Sample sample;
+	sample.throughput = time > sample_start_time ? latencies.size() / ((time - sample_start_time) / 1000000) : 0;
+	sample.mean_latency = accumulate(latencies.begin(), latencies.end(), 0.0) / latencies.size();
+	sort(latencies.begin(), latencies.end());
+	sample.median_latency = latencies[latencies.size() / 2];
+	sample.latency_95th = latencies[min(latencies.size() - 1, (size_t)ceil(latencies.size() * 0.95) - 1)];
+	sample.latency_99th = latencies[min(latencies.size() - 1, (size_t)ceil(latencies.size() * 0.99) - 1)];
+	sample.end_time = time;
+	samples.push_back(sample);
+	latencies.clear();
+	phase = FUNCTIONAL;
+	num_IOs_in_phase = 0;
+	if ((int)samples.size() >= SAMPLING_MIN_SAMPLES) {
+		Estimate throughput = estimate([](Sample const& s) { return s.throughput; });
+		Estimate latency = estimate([](Sample const& s) { return s.mean_latency; });
+		bool is_precise = throughput.error <= SAMPLING_TARGET_ERROR * throughput.mean && latency.error <= SAMPLING_TARGET_ERROR * latency.mean;
+		period = is_precise ? period * 2 : SAMPLING_PERIOD;
+	}
+}
+
+// The confidence interval assumes the sample averages are normally distributed, which holds for enough samples
+Sampled_Simulation::Estimate Sampled_Simulation::estimate(double (*metric)(Sample const&)) {
+	const double z = 1.96;
+	Estimate estimate;
+	estimate.mean = 0;
+	for (auto sample : samples) {
+		estimate.mean += metric(sample);
+	}
+	estimate.mean /= max((size_t)1, samples.size());
+	double variance = 0;
+	for (auto sample : samples) {
+		variance += (metric(sample) - estimate.mean) * (metric(sample) - estimate.mean);
+	}
+	variance /= max((size_t)1, samples.size() - 1);
+	estimate.error = samples.size() > 1 ? z * sqrt(variance / samples.size()) : numeric_limits<double>::infinity();
+	double relative_deviation = estimate.mean > 0 ? sqrt(variance) / estimate.mean : 0;
+	estimate.samples_needed = (long)ceil(pow(z * relative_deviation / SAMPLING_TARGET_ERROR, 2));
+	return estimate;
+}
+
+void Sampled_Simulation::print(FILE* stream) {
+	if (SAMPLING_PERIOD <= 0) {
+		return;
+	}
+	fprintf(stream, "Sampled simulation:\t%lu samples, with %ld IOs timed and %ld IOs executed functionally\n", samples.size(), num_detailed_IOs, num_functional_IOs);
+	if (samples.empty()) {
+		fprintf(stream, "\n");
+		return;
+	}
+	fprintf(stream, "metric\testimate\t95%% confidence interval\trelative error\tsamples needed\n");
+	vector<pair<string, double (*)(Sample const&)> > metrics = {
+		{ "throughput", [](Sample const& s) { return s.throughput; } },
+		{ "mean latency", [](Sample const& s) { return s.mean_latency; } },
+		{ "median latency", [](Sample const& s) { return s.median_latency; } },
+		{ "95th percentile latency", [](Sample const& s) { return s.latency_95th; } },
+		{ "99th percentile latency", [](Sample const& s) { return s.latency_99th; } }
+	};
+	for (auto metric : metrics) {
+		Estimate e = estimate(metric.second);
+		fprintf(stream, "%s\t%f\t+-%f\t%f\t%ld\n", metric.first.c_str(), e.mean, e.error, e.mean > 0 ? e.error / e.mean : 0, e.samples_needed);
+	}
+	fprintf(stream, "sample\tend time\tthroughput\tmean latency\tmedian latency\t95th percentile latency\t99th percentile latency\n");
+	for (uint i = 0; i < samples.size(); i++) {
+		Sample const& s = samples[i];
+		fprintf(stream, "%u\t%f\t%f\t%f\t%f\t%f\t%f\n", i, s.end_time, s.throughput, s.mean_latency, s.median_latency, s.latency_95th, s.latency_99th);
+	}
+	fprintf(stream, "\n");
+}
@@ -0,0 +1,112 @@
+#include "../ssd.h"
+using namespace ssd;
+
+vector<Steady_State_Monitor::Window> Steady_State_Monitor::windows = vector<Steady_State_Monitor::Window>();
+vector<double> Steady_State_Monitor::latencies = vector<double>();
+long Steady_State_Monitor::num_app_writes = 0;
+long Steady_State_Monitor::num_gc_writes = 0;
+long Steady_State_Monitor::num_IOs = 0;
+double Steady_State_Monitor::window_start_time = 0;
+uint Steady_State_Monitor::first_window_of_workload = 0;
+int Steady_State_Monitor::steady_state_window = UNDEFINED;
+
+void Steady_State_Monitor::init() {
+	windows.clear();
+	latencies.clear();
+	num_app_writes = 0;
+	num_gc_writes = 0;
+	num_IOs = 0;
+	window_start_time = 0;
+	first_window_of_workload = 0;
+	steady_state_window = UNDEFINED;
+}
+
+// The IOs of the current window mix the old and new workloads, so they are not counted.
+// Steady state has to be reached again by the new workload.
+void Steady_State_Monitor::register_workload_change(double time) {
+	steady_state_window = UNDEFINED;
+	latencies.clear();
+	num_app_writes = 0;
+	num_gc_writes = 0;
+	window_start_time = time;
+	first_window_of_workload = windows.size();
+}
+
+// Flash writes done by garbage collection count towards the write amplification of the window in which they complete
+void Steady_State_Monitor::register_completed_event(Event const& event) {
+	if (STEADY_STATE_WINDOW <= 0) {
+		return;
+	}
+	event_type type = event.get_event_type();
+	if ((type == WRITE || type == COPY_BACK) && event.is_garbage_collection_op()) {
+		num_gc_writes++;
+	}
+	if (!event.is_original_application_io() || (type != WRITE && type != READ_TRANSFER)) {
+		return;
+	}
+	if (type == WRITE) {
+		num_app_writes++;
+	}
+	num_IOs++;
+	latencies.push_back(event.get_latency());
+	if ((long)latencies.size() >= STEADY_STATE_WINDOW) {
+		end_window(event.get_current_time());
+	}
+}
+
+void Steady_State_Monitor::end_window(double time) {
+	Window window;
+	window.throughput = time > window_start_time ? latencies.size() / ((time - window_start_time) / 1000000) : 0;
+	window.write_amplification = 1 + num_gc_writes / (double)max(1L, num_app_writes);
+	sort(latencies.begin(), latencies.end());
+	window.median_latency = latencies[latencies.size() / 2];
+	window.tail_latency = latencies[min(latencies.size() - 1, (size_t)ceil(latencies.size() * 0.99) - 1)];
+	window.end_time = time;
+	window.num_IOs_so_far = num_IOs;
+	windows.push_back(window);
+	latencies.clear();
+	num_app_writes = 0;
+	num_gc_writes = 0;
+	window_start_time = time;
+	if (steady_state_window == UNDEFINED
+			&& is_stable([](Window const& w) { return w.throughput; }, STEADY_STATE_THROUGHPUT_TOLERANCE)
+			&& is_stable([](Window const& w) { return w.write_amplification; }, STEADY_STATE_WRITE_AMPLIFICATION_TOLERANCE)
+			&& is_stable([](Window const& w) { return w.median_latency; }, STEADY_STATE_LATENCY_TOLERANCE)
+			&& is_stable([](Window const& w) { return w.tail_latency; }, STEADY_STATE_LATENCY_TOLERANCE)) {
+		steady_state_window = windows.size() - 1;
+	}
+}
+
+// A metric is stable if its values in the last STEADY_STATE_NUM_WINDOWS windows are within tolerance of their average
+bool Steady_State_Monitor::is_stable(double (*metric)(Window const&), double tolerance) {
+	if ((int)(windows.size() - first_window_of_workload) < STEADY_STATE_NUM_WINDOWS) {
+		return false;
+	}
+	double sum = 0, min_value = numeric_limits<double>::infinity(), max_value = -numeric_limits<double>::infinity();
+	for (uint i = windows.size() - STEADY_STATE_NUM_WINDOWS; i < windows.size(); i++) {
+		double value = metric(windows[i]);
+		sum += value;
+		min_value = min(min_value, value);
+		max_value = max(max_value, value);
+	}
+	double average = sum / STEADY_STATE_NUM_WINDOWS;
+	return max_value - average <= tolerance * average && average - min_value <= tolerance * average;
+}
+
+void Steady_State_Monitor::print(FILE* stream) {
+	if (STEADY_STATE_WINDOW <= 0) {
+		return;
+	}
+	if (has_reached_steady_state()) {
+		Window const& window = windows[steady_state_window];
+		fprintf(stream, "Reached steady state after:\t%ld application IOs, at time %f\n", window.num_IOs_so_far, window.end_time);
+	} else {
+		fprintf(stream, "Did not reach steady state in:\t%ld application IOs\n", num_IOs);
+	}
+	fprintf(stream, "window\tapplication IOs\tend time\tthroughput\twrite amplification\tmedian latency\t99th percentile latency\n");
+	for (uint i = 0; i < windows.size(); i++) {
+		Window const& w = windows[i];
+		fprintf(stream, "%u\t%ld\t%f\t%f\t%f\t%f\t%f\n", i, w.num_IOs_so_far, w.end_time, w.throughput, w.write_amplification, w.median_latency, w.tail_latency);
+	}
+	fprintf(stream, "\n");
+}
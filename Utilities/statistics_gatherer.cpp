@@ -74,6 +74,9 @@ void StatisticsGatherer::register_completed_event(Event const& event) {
 	if (!record_statistics) {
 		return;
 	}
+	if (this == inst) {
+		Steady_State_Monitor::register_completed_event(event);
+	}
 	end_time = max(end_time, event.get_current_time());
 
 	uint current_window = floor(event.get_current_time() / io_counter_window_size);
@@ -169,3 +169,109 @@ vector<Thread*> Synch_Random_Workload::generate() {
 	Simple_Thread* t = new Synchronous_Random_Writer(min_lba, max_lba, 2345);
 	return vector<Thread*>(1, t);
 }
+
+//*****************************************************************************************
+//				LSM COMPACTION
+//*****************************************************************************************
+
+LSM_Compaction_Workload::LSM_Compaction_Workload(int file_size, int level_fanout, double write_rate)
+	: Workload_Definition(),
+	  file_size(file_size),
+	  level_fanout(level_fanout),
+	  write_rate(write_rate)
+{}
+
+vector<Thread*> LSM_Compaction_Workload::generate() {
+	Thread* t = new LSM_Tree(min_lba, max_lba, file_size, level_fanout, write_rate);
+	return vector<Thread*>(1, t);
+}
+
+//*****************************************************************************************
+//				OLTP
+//*****************************************************************************************
+
+OLTP_Workload::OLTP_Workload(double dirty_page_rate, double checkpoint_interval, int num_readers)
+	: Workload_Definition(),
+	  dirty_page_rate(dirty_page_rate),
+	  checkpoint_interval(checkpoint_interval),
+	  num_readers(num_readers)
+{}
+
+vector<Thread*> OLTP_Workload::generate() {
+	long log_end = min_lba + (max_lba - min_lba + 1) / 20;
+	Thread* log_writer = new Simple_Thread(new Sequential_IO_Pattern(min_lba, log_end), new WRITES(), 1, INFINITE);
+	Thread* checkpointer = new Checkpoint_Thread(log_end + 1, max_lba, dirty_page_rate, checkpoint_interval, 4573);
+	vector<Thread*> threads;
+	threads.push_back(log_writer);
+	threads.push_back(checkpointer);
+	Individual_Threads_Statistics::init();
+	Individual_Threads_Statistics::register_thread(log_writer, "WAL Writer (commit latency)");
+	Individual_Threads_Statistics::register_thread(checkpointer, "Checkpoint Writer");
+	for (int i = 0; i < num_readers; i++) {
+		Thread* reader = new Synchronous_Random_Reader(log_end + 1, max_lba, 3617 + i);
+		threads.push_back(reader);
+		Individual_Threads_Statistics::register_thread(reader, "Random Page Reader");
+	}
+	return threads;
+}
+
+//*****************************************************************************************
+//				PRECONDITIONED
+//*****************************************************************************************
+
+Preconditioned_Workload::Preconditioned_Workload(Workload_Definition* workload)
+	: Workload_Definition(),
+	  workload(workload)
+{}
+
+Preconditioned_Workload::~Preconditioned_Workload() {
+	delete workload;
+}
+
+vector<Thread*> Preconditioned_Workload::generate() {
+	Simple_Thread* precondition = new Asynchronous_Sequential_Writer(min_lba, max_lba);
+	precondition->add_follow_up_threads(workload->generate_instance());
+	return vector<Thread*>(1, precondition);
+}
+
+//*****************************************************************************************
+//				SNIA PTS
+//*****************************************************************************************
+
+SNIA_PTS_Workload::SNIA_PTS_Workload(pts_test test, int queue_depth, double point_duration)
+	: Workload_Definition(),
+	  test(test),
+	  queue_depth(queue_depth != UNDEFINED ? queue_depth : test == PTS_LATENCY ? 1 : 32),
+	  point_duration(point_duration),
+	  results(NULL)
+{}
+
+SNIA_PTS_Workload::~SNIA_PTS_Workload() {
+	delete results;
+}
+
+vector<Thread*> SNIA_PTS_Workload::generate() {
+	delete results;
+	results = new SNIA_PTS_Results(test);
+	Thread* thread = new SNIA_PTS_Thread(min_lba, max_lba, results, queue_depth, point_duration, 7517);
+	Individual_Threads_Statistics::init();
+	Individual_Threads_Statistics::register_thread(thread, "SNIA PTS " + SNIA_PTS_Results::get_test_name(test) + " test");
+	return vector<Thread*>(1, thread);
+}
+
+// The IOPS test also gets the IOPS matrix of block sizes and read/write mixes
+void SNIA_PTS_Workload::write_results(string folder_name) const {
+	assert(results != NULL);
+	string test_name = SNIA_PTS_Results::get_test_name(test);
+	FILE* file = fopen((folder_name + test_name + ".csv").c_str(), "w");
+	results->print_csv(file);
+	fclose(file);
+	file = fopen((folder_name + test_name + "_steady_state.csv").c_str(), "w");
+	results->print_steady_state_csv(file);
+	fclose(file);
+	if (test == PTS_IOPS) {
+		file = fopen((folder_name + "iops_matrix.csv").c_str(), "w");
+		results->print_iops_matrix_csv(file);
+		fclose(file);
+	}
+}
@@ -24,7 +24,7 @@ Address::Address(uint package, uint die, uint plane, uint block, uint page, enum
 	return;
 }
 
-Address::Address(uint address, enum address_valid valid):
+Address::Address(ulong address, enum address_valid valid):
 	valid(valid)
 {
 	set_linear_address(address);
@@ -64,33 +64,58 @@ void Address::print(FILE *stream) const
 	fprintf(stream, "(%d, %d, %d, %d, %d, %d)", package, die, plane, block, page, (int) valid);
 }
 
-void Address::set_linear_address(ulong address)
-{
-	page = address % BLOCK_SIZE;
-	address /= BLOCK_SIZE;
-	block = address % PLANE_SIZE;
-	address /= PLANE_SIZE;
-	plane = address % DIE_SIZE;
-	address /= DIE_SIZE;
-	die = address % PACKAGE_SIZE;
-	address /= PACKAGE_SIZE;
-	package = address % SSD_SIZE;
-	address /= SSD_SIZE;
-}
-
 void Address::set_linear_address(ulong address, enum address_valid valid)
 {
 	set_linear_address(address);
 	this->valid = valid;
 }
 
-unsigned long Address::get_linear_address() const
+// =================  Address_Geometry  =============================
+
+Address_Geometry::Divisor Address_Geometry::pages_per_block = Address_Geometry::Divisor();
+Address_Geometry::Divisor Address_Geometry::blocks_per_plane = Address_Geometry::Divisor();
+Address_Geometry::Divisor Address_Geometry::planes_per_die = Address_Geometry::Divisor();
+Address_Geometry::Divisor Address_Geometry::dies_per_package = Address_Geometry::Divisor();
+
+void Address_Geometry::init() {
+	pages_per_block = Divisor(BLOCK_SIZE);
+	blocks_per_plane = Divisor(PLANE_SIZE);
+	planes_per_die = Divisor(DIE_SIZE);
+	dies_per_package = Divisor(PACKAGE_SIZE);
+}
+
+// =================  Geometry_Dispatch  =============================
+
+Geometry_Dispatch::geometry Geometry_Dispatch::selected = Geometry_Dispatch::RUNTIME;
+
+void Geometry_Dispatch::init() {
+	selected = RUNTIME;
+	if (!SPECIALIZE_GEOMETRY) {
+		return;
+	}
+	if (Small_Geometry::matches_configuration()) {
+		selected = SMALL;
+	} else if (Big_Geometry::matches_configuration()) {
+		selected = BIG;
+	} else if (Conf_File_Geometry::matches_configuration()) {
+		selected = CONF_FILE;
+	}
+}
+
+// For a divisor d that is not a power of two, with 2^(l-1) < d < 2^l, the magic number is ceil(2^(63+l) / d).
+// It is below 2^64, and floor(n * magic / 2^(63+l)) = floor(n / d) for all n < 2^63.
+Address_Geometry::Divisor::Divisor(ulong divisor)
+	: divisor(divisor), magic(0), shift(0)
 {
-	unsigned long 			address = 0;
-	if (valid == PAGE) 		address += page;
-	if (valid >= BLOCK) 	address += BLOCK_SIZE * block;
-	if (valid >= PLANE) 	address += BLOCK_SIZE * PLANE_SIZE * plane;
-	if (valid >= DIE) 		address += BLOCK_SIZE * PLANE_SIZE * DIE_SIZE * die;
-	if (valid >= PACKAGE) 	address += BLOCK_SIZE * PLANE_SIZE * DIE_SIZE * PACKAGE_SIZE * package;
-	return address;
+	assert(divisor > 0);
+	uint log = 0;
+	while ((1UL << log) < divisor) {
+		log++;
+	}
+	if ((1UL << log) == divisor) {
+		shift = log;
+		return;
+	}
+	shift = 63 + log;
+	magic = (ulong)((((unsigned __int128)1 << shift) + divisor - 1) / divisor);
 }
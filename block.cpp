@@ -6,10 +6,12 @@
 
 using namespace ssd;
 
+const Page Block::EMPTY_PAGE = Page();
+
 Block::Block(long physical_address):
 			pages_invalid(0),
 			physical_address(physical_address),
-			data(BLOCK_SIZE, Page()),
+			data(),
 			pages_valid(0),
 			erases_remaining(BLOCK_ERASES)
 {}
@@ -17,24 +19,32 @@ Block::Block(long physical_address):
 Block::Block():
 			pages_invalid(0),
 			physical_address(0),
-			data(BLOCK_SIZE, Page()),
+			data(),
 			pages_valid(0),
 			erases_remaining(BLOCK_ERASES)
 {}
 
+Page& Block::get_writable_page(uint i)
+{
+	if (data.empty()) {
+		data.assign(BLOCK_SIZE, Page());
+	}
+	return data[i];
+}
+
 enum status Block::read(Event &event)
 {
-	return data[event.get_address().page]._read(event);
+	return get_writable_page(event.get_address().page)._read(event);
 }
 
 enum status Block::write(Event &event)
 {
-	if (event.get_address().page > 0 && data[event.get_address().page - 1].get_state() == EMPTY) {
+	if (event.get_address().page > 0 && get_page(event.get_address().page - 1).get_state() == EMPTY) {
 		printf("\n");
 		event.print();
-		assert(data[event.get_address().page - 1].get_state() != EMPTY);
+		assert(get_page(event.get_address().page - 1).get_state() != EMPTY);
 	}
-	enum status ret = data[event.get_address().page]._write(event);
+	enum status ret = get_writable_page(event.get_address().page)._write(event);
 	pages_valid++;
 	return ret;
 }
@@ -51,7 +61,7 @@ enum status Block::_erase(Event &event)
 		return FAILURE;
 	}
 
-	for(uint i = 0; i < BLOCK_SIZE; i++)
+	for(uint i = 0; i < data.size(); i++)
 	{
 		//assert(data[i].get_state() == INVALID);
 		data[i].set_state(EMPTY);
@@ -68,7 +78,7 @@ enum status Block::_erase(Event &event)
 void Block::invalidate_page(uint page)
 {
 	assert(page < BLOCK_SIZE);
-	data[page].set_state(INVALID);
+	get_writable_page(page).set_state(INVALID);
 	pages_invalid++;
 	pages_valid--;
 }
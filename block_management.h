@@ -22,11 +22,13 @@ public:
 	void schedule_gc(double time, int package, int die, int block, int klass);
 	vector<deque<Event*> > migrate(Event * gc_event);
 	void update_structures(Address const& a, double time);
+	void erase_once_invalid(Address const& a, double time);
+	void erase_block(Address const& a, double time);
 	void print_pending_migrations();
 	deque<Event*> trigger_next_migration(Event * gc_read);
 	bool more_migrations(Event * gc_read);
 	void register_event_completion(Event* event);
-	void register_ECC_check_on(uint logical_address);
+	void register_ECC_check_on(ulong logical_address);
 	uint how_many_gc_operations_are_scheduled() const;
 	void set_block_manager(Block_manager_parent* b) { bm = b; }
 	Garbage_Collector* get_garbage_collector() { return gc; }
@@ -43,7 +45,7 @@ public:
     }
 private:
 	bool copy_back_allowed_on(long logical_address);
-	void register_copy_back_operation_on(uint logical_address);
+	void register_copy_back_operation_on(ulong logical_address);
 	void handle_erase_completion(Event* event);
 	void handle_trim_completion(Event* event);
 	void issue_erase(Address ra, double time);
@@ -98,6 +100,11 @@ public:
 		num_available_pages_for_new_writes -= num;
 		//printf("%d   %d\n", num_available_pages_for_new_writes, num_free_pages);
 	}
+	// An erase frees all the pages of a block, so the pages of a block that is erased before it is full are taken out first
+	void register_unwritten_pages_erased(int num) {
+		num_free_pages -= num;
+		num_available_pages_for_new_writes -= num;
+	}
 	vector<Block*> const& get_all_blocks() const { return all_blocks; }
 	uint sort_into_age_class(Address const& address) const;
 	void copy_state(Block_manager_parent* bm);
@@ -131,16 +138,21 @@ public:
 	Address find_free_unused_block(uint package_id, double time);
 	Address find_free_unused_block(enum age age, double time);
 	pair<bool, pair<int, int> > get_free_block_pointer_with_shortest_IO_queue(vector<vector<Address> > const& dies) const;
+	template <class Geometry>
+	pair<bool, pair<int, int> > get_free_block_pointer_with_shortest_IO_queue(vector<vector<Address> > const& dies, Geometry) const;
 	void return_unfilled_block(Address block_address, double current_time, bool give_to_block_pointers);
 	int get_num_free_blocks() const;
 	void print_free_blocks() const;
 protected:
 	virtual Address choose_best_address(Event& write) = 0;
 	virtual Address choose_any_address(Event const& write) = 0;
+	virtual uint add_free_block(Address const& block, uint age_class);
 	void increment_pointer(Address& pointer);
 	bool can_schedule_write_immediately(Address const& prospective_dest, double current_time);
 	bool can_write(Event const& write) const;
 	Address get_free_block_pointer_with_shortest_IO_queue();
+	template <class Geometry>
+	void check_if_should_trigger_more_GC(Event const& event, Geometry);
 
 	inline bool has_free_pages(Address const& address) const { return address.valid == PAGE && address.page < BLOCK_SIZE; }
 
@@ -160,8 +172,8 @@ private:
 
 
 	bool copy_back_allowed_on(long logical_address);
-	void register_copy_back_operation_on(uint logical_address);
-	void register_ECC_check_on(uint logical_address);
+	void register_copy_back_operation_on(ulong logical_address);
+	void register_ECC_check_on(ulong logical_address);
 	bool schedule_queued_erase(Address location);
 
 	vector<Block*> all_blocks;
@@ -341,6 +353,28 @@ private:
 	bool channel_alternation;
 };
 
+// A BM that allocates and erases superblocks, which are made of the block with the same index in every die.
+// Writes are striped across the open superblock in channel-first order, and an erased block only becomes free
+// once every other block of its superblock has been erased too, so that the free blocks always form whole superblocks.
+class Block_manager_superblock : public Block_manager_parent {
+public:
+	Block_manager_superblock();
+	~Block_manager_superblock() {}
+	void register_write_outcome(Event const& event, enum status status);
+	void register_erase_outcome(Event& event, enum status status);
+	static int get_superblock_id(Address const& block);
+	static Address get_member(int superblock_id, int package, int die);
+	static int get_num_superblocks() { return DIE_SIZE * PLANE_SIZE; }
+protected:
+	Address choose_best_address(Event& write);
+	Address choose_any_address(Event const& write);
+	uint add_free_block(Address const& block, uint age_class);
+private:
+	void move_address_cursor();
+	Address address_cursor;
+	vector<int> num_erased_members;  // for each superblock, the number of its blocks that have been erased since it was last freed
+};
+
 // A BM that assigns each write to the die with the shortest queue, as well as hot-cold seperation
 class Shortest_Queue_Hot_Cold_BM : public Block_manager_parent {
 public:
@@ -482,6 +516,8 @@ public:
 	virtual void register_event_completion(Event const& event) {};
 	virtual Block* choose_gc_victim(int package_id, int die_id, int klass) const = 0;
 	virtual void commit_choice_of_victim(Address const& phys_address, double time) = 0;
+	// The pages that were already taken out of those available for new writes to migrate the valid pages of a future victim
+	virtual int get_num_pages_reserved_for(Block const& victim) const { return 0; }
 	void set_block_manager(Block_manager_parent* b) { bm = b; }
 	virtual void set_scheduler(IOScheduler*) {}
     friend class boost::serialization::access;
@@ -515,6 +551,8 @@ public:
 
 	// Called by the block manager to ask the garbage-collector for a good block to garbage-collect in a given package, die, and with a certain age.
 	Block* choose_gc_victim(int package_id, int die_id, int klass) const;
+	template <class Geometry>
+	Block* choose_gc_victim(int package_id, int die_id, int klass, Geometry) const;
 	// Called by the block manager when a GC operation for a certain block has been issued. This block is removed from the gc_candidates structure.
 	void commit_choice_of_victim(Address const& phys_address, double time);
 	friend class boost::serialization::access;
@@ -547,6 +585,44 @@ private:
 	vector<vector<queue<int> > > gc_candidates;  // for each die, a queue of blocks to be erased
 };
 
+// Picks the superblock with the fewest valid pages in all of its blocks, and then garbage-collects every one of its blocks.
+// A new victim is only chosen once all blocks of the previous one have been chosen.
+class Garbage_Collector_Superblock : public Garbage_Collector {
+public:
+	Garbage_Collector_Superblock();
+	Garbage_Collector_Superblock(Ssd* ssd, Block_manager_parent* bm);
+	virtual void register_event_completion(Event const& event);
+	Block* choose_gc_victim(int package_id, int die_id, int klass) const;
+	void commit_choice_of_victim(Address const& phys_address, double time);
+	int get_num_pages_reserved_for(Block const& victim) const;
+	friend class boost::serialization::access;
+    template<class Archive>
+    void serialize(Archive & ar, const unsigned int version)
+    {
+    	ar & boost::serialization::base_object<Garbage_Collector>(*this);
+    	ar & gc_candidates;
+    	ar & victims;
+    }
+private:
+	enum member_state { NOT_CHOSEN, CHOSEN, ERASED };
+	struct member {
+		member_state state;
+		int num_reserved_pages;
+		member() : state(NOT_CHOSEN), num_reserved_pages(0) {}
+	    template<class Archive>
+	    void serialize(Archive & ar, const unsigned int version)
+	    {
+	    	ar & state;
+	    	ar & num_reserved_pages;
+	    }
+	};
+	Block* get_block(int superblock_id, int package, int die) const;
+	int choose_victim_superblock() const;
+	bool has_unchosen_members() const;
+	set<int> gc_candidates;  // superblocks with invalid pages
+	map<int, vector<vector<member> > > victims;  // superblocks being garbage-collected, with the state of each of their blocks
+};
+
 class flash_resident_ftl_garbage_collection : public Garbage_Collector {
 public:
 	flash_resident_ftl_garbage_collection(Ssd* ssd, Block_manager_parent* bm) : Garbage_Collector(ssd, bm), ftl(NULL) {}
@@ -75,9 +75,11 @@ double PAGE_WRITE_DELAY = 0.00001;
 uint PAGE_SIZE = 4096;
 
 // The IO scheduler used by the Operating System.
-// There are currently two schedulers available
+// There are currently three schedulers available
 // 0 corresponds to a FIFO scheduler, which is similar to the noop IO scheduler in Linux
 // 1 corresponds to a fair scheduler that scheduels IOs in a round robin manner from different threads. It is similar to the CFQ Linux scheduler
+// 2 corresponds to a weighted fair scheduler that shares the device between threads according to their IO weights and latency targets.
+//   It is similar to the cgroup io.weight controller and the BFQ Linux scheduler. See Thread::set_io_weight and Thread::set_latency_target
 // You can create more schedulers by extending the OS_Scheduler class.
 int OS_SCHEDULER = 0;
 
@@ -116,6 +118,8 @@ int MAX_CONCURRENT_GC_OPS = 1;
  * 		across the logical address space. After a certain threshold of such writes, defined by the variable SEQUENTIAL_LOCALITY_THRESHOLD,
  * 		it clusters pages from the same sequential write in the same flash blocks.
  * 4 -> Round Robin
+ * 8 -> Superblock - Allocates and erases a block in every die at a time, and stripes writes across them in channel-first order.
+ * 		Garbage-collection victims are then always chosen by the superblock policy.
  */
 int BLOCK_MANAGER_ID = 3;
 
@@ -123,6 +127,7 @@ int BLOCK_MANAGER_ID = 3;
  * The policy used to choose a garbage-collection victim
  * 0 -> Greedy - for each LUN, always picks the block with the least number of pages
  * 1 -> LRU -- for each LUN, always picks the block that was cleaned last
+ * 2 -> Superblock -- picks the superblock, made of the block with the same index in every LUN, with the least number of valid pages
  */
 int GARBAGE_COLLECTION_POLICY = 0;
 
@@ -144,6 +149,8 @@ int GREED_SCALE = 2;
  * 1 -> DFTL
  * 2 -> FAST
  * 3 -> LSM FTL
+ * 4 -> DFTL with its mapping cache in the host memory buffer
+ * 5 -> Zoned namespace (ZNS), where the host places the data in zones and there is no garbage collection
  */
 int FTL_DESIGN = 0;
 bool IS_FTL_PAGE_MAPPING = 0;
@@ -180,6 +187,57 @@ uint MAX_ITEMS_IN_COPY_BACK_MAP = 1024;
 /* Defines the maximal length of the number of outstanding IOs that the OS can submit to the SSD  */
 int MAX_SSD_QUEUE_SIZE = 32;
 
+// The operating system can merge IOs to adjacent logical addresses into larger requests before submitting them to the SSD.
+// This is similar to front and back merges in the Linux block layer. IOs are held in a plug while the OS has more IOs to dispatch.
+// They are merged with a plugged request of the same type if they extend it and arrived within OS_PLUG_WINDOW microseconds of its first IO.
+// OS_MAX_REQUEST_SIZE is the maximal size of a merged request in pages. Setting it to 1 disables merging.
+int OS_MAX_REQUEST_SIZE = 1;
+double OS_PLUG_WINDOW = 100;
+
+// The operating system can keep a page cache of PAGE_CACHE_SIZE pages in front of the SSD. Setting it to 0 disables the page cache.
+// Reads that hit the cache and buffered writes complete after PAGE_CACHE_ACCESS_DELAY microseconds per page.
+// Dirty pages are written back in batches of up to PAGE_CACHE_WRITEBACK_BATCH pages once more than PAGE_CACHE_DIRTY_BACKGROUND_RATIO of the cache is dirty,
+// and writers are throttled once more than PAGE_CACHE_DIRTY_RATIO of the cache is dirty or under writeback.
+// Sequential reads are read ahead with a window that doubles up to PAGE_CACHE_READAHEAD_MAX pages. Setting it to 0 disables readahead.
+int PAGE_CACHE_SIZE = 0;
+double PAGE_CACHE_ACCESS_DELAY = 1;
+double PAGE_CACHE_DIRTY_RATIO = 0.2;
+double PAGE_CACHE_DIRTY_BACKGROUND_RATIO = 0.1;
+int PAGE_CACHE_WRITEBACK_BATCH = 256;
+int PAGE_CACHE_READAHEAD_MAX = 32;
+
+// A run ends once it has reached steady state, even if its IO limit has not been reached yet.
+// This is when the application throughput, write amplification, and median and 99th percentile latencies of the application IOs
+// have each stayed within their tolerance, relative to their average, over the last STEADY_STATE_NUM_WINDOWS windows.
+// A window is STEADY_STATE_WINDOW application IOs. Setting it to 0 disables this, so that runs only end at their IO limit.
+int STEADY_STATE_WINDOW = 0;
+int STEADY_STATE_NUM_WINDOWS = 5;
+double STEADY_STATE_THROUGHPUT_TOLERANCE = 0.1;
+double STEADY_STATE_WRITE_AMPLIFICATION_TOLERANCE = 0.05;
+double STEADY_STATE_LATENCY_TOLERANCE = 0.2;
+
+// Calibration runs the calibration workload functionally, with no timing model, which takes the SSD to steady state much faster.
+// It only applies to page mapping FTLs. Setting it to 0 runs calibration workloads through the timed simulation instead.
+int FAST_FORWARD_CALIBRATION = 1;
+
+// Sampled simulation alternates detailed samples, which are timed, with functional stretches that only update the FTL and flash state.
+// A sample is SAMPLING_WARMUP application IOs that are not measured, followed by SAMPLING_WINDOW measured IOs. Functional execution
+// garbage collects as soon as it is asked to, and so leaves more free blocks than timed execution, so the warm-up has to be long enough
+// for garbage collection to fall back to its timed pace. Otherwise the samples underestimate the latencies.
+// The samples are SAMPLING_PERIOD application IOs apart. Once there are SAMPLING_MIN_SAMPLES samples, the period is doubled whenever
+// the 95% confidence intervals of the throughput and mean latency are within SAMPLING_TARGET_ERROR of the estimates, and reset otherwise.
+// It only applies to page mapping FTLs. Setting SAMPLING_PERIOD to 0 disables this, so that every IO is timed.
+int SAMPLING_PERIOD = 0;
+int SAMPLING_WARMUP = 4000;
+int SAMPLING_WINDOW = 1000;
+int SAMPLING_MIN_SAMPLES = 10;
+double SAMPLING_TARGET_ERROR = 0.03;
+
+// Runs the hot loops of the simulator, like the garbage collection triggers and the shortest queue search, in versions compiled
+// for a fixed geometry if the configured geometry is one of them. See Geometry_Dispatch in ssd.h. Setting it to 0 always runs the
+// versions that read the geometry from the configuration.
+int SPECIALIZE_GEOMETRY = 0;
+
 // These are internal deadlines for scheduling IOs inside the SSD. They are in microseconds.
 int WRITE_DEADLINE = 10000000;
 int READ_DEADLINE =  10000000;
@@ -191,7 +249,12 @@ int PAGE_HOTNESS_MEASURER = 0;
 // The amount of SRAM available to the FTL in bytes
 int SRAM;
 
-void load_entry(char *name, double value, uint line_number) {
+// Knobs that belong to a specific FTL, like DFTL::ENTRIES_PER_TRANSLATION_PAGE, are set and printed by the FTLs,
+// since their classes are not declared here
+bool load_ftl_entry(const char *name, double value);
+void print_ftl_config(FILE *stream);
+
+bool load_entry(const char *name, double value, uint line_number) {
 	/* cheap implementation - go through all possibilities and match entry */
 	if (!strcmp(name, "BUS_CTRL_DELAY"))
 		BUS_CTRL_DELAY = value;
@@ -233,12 +296,52 @@ void load_entry(char *name, double value, uint line_number) {
 		MAX_CONCURRENT_GC_OPS = value;
 	else if (!strcmp(name, "OS_SCHEDULER"))
 		OS_SCHEDULER = value;
+	else if (!strcmp(name, "OS_MAX_REQUEST_SIZE"))
+		OS_MAX_REQUEST_SIZE = value;
+	else if (!strcmp(name, "OS_PLUG_WINDOW"))
+		OS_PLUG_WINDOW = value;
+	else if (!strcmp(name, "PAGE_CACHE_SIZE"))
+		PAGE_CACHE_SIZE = value;
+	else if (!strcmp(name, "PAGE_CACHE_ACCESS_DELAY"))
+		PAGE_CACHE_ACCESS_DELAY = value;
+	else if (!strcmp(name, "PAGE_CACHE_DIRTY_RATIO"))
+		PAGE_CACHE_DIRTY_RATIO = value;
+	else if (!strcmp(name, "PAGE_CACHE_DIRTY_BACKGROUND_RATIO"))
+		PAGE_CACHE_DIRTY_BACKGROUND_RATIO = value;
+	else if (!strcmp(name, "PAGE_CACHE_WRITEBACK_BATCH"))
+		PAGE_CACHE_WRITEBACK_BATCH = value;
+	else if (!strcmp(name, "PAGE_CACHE_READAHEAD_MAX"))
+		PAGE_CACHE_READAHEAD_MAX = value;
+	else if (!strcmp(name, "STEADY_STATE_WINDOW"))
+		STEADY_STATE_WINDOW = value;
+	else if (!strcmp(name, "STEADY_STATE_NUM_WINDOWS"))
+		STEADY_STATE_NUM_WINDOWS = value;
+	else if (!strcmp(name, "STEADY_STATE_THROUGHPUT_TOLERANCE"))
+		STEADY_STATE_THROUGHPUT_TOLERANCE = value;
+	else if (!strcmp(name, "STEADY_STATE_WRITE_AMPLIFICATION_TOLERANCE"))
+		STEADY_STATE_WRITE_AMPLIFICATION_TOLERANCE = value;
+	else if (!strcmp(name, "STEADY_STATE_LATENCY_TOLERANCE"))
+		STEADY_STATE_LATENCY_TOLERANCE = value;
+	else if (!strcmp(name, "FAST_FORWARD_CALIBRATION"))
+		FAST_FORWARD_CALIBRATION = value;
+	else if (!strcmp(name, "SAMPLING_PERIOD"))
+		SAMPLING_PERIOD = value;
+	else if (!strcmp(name, "SAMPLING_WARMUP"))
+		SAMPLING_WARMUP = value;
+	else if (!strcmp(name, "SAMPLING_WINDOW"))
+		SAMPLING_WINDOW = value;
+	else if (!strcmp(name, "SAMPLING_MIN_SAMPLES"))
+		SAMPLING_MIN_SAMPLES = value;
+	else if (!strcmp(name, "SAMPLING_TARGET_ERROR"))
+		SAMPLING_TARGET_ERROR = value;
 	else if (!strcmp(name, "GREED_SCALE"))
 		GREED_SCALE = value;
 	else if (!strcmp(name, "ALLOW_DEFERRING_TRANSFERS"))
 		ALLOW_DEFERRING_TRANSFERS = value;
 	else if (!strcmp(name, "SCHEDULING_SCHEME"))
 		SCHEDULING_SCHEME = value;
+	else if (!strcmp(name, "SPECIALIZE_GEOMETRY"))
+		SPECIALIZE_GEOMETRY = value;
 	else if (!strcmp(name, "WRITE_DEADLINE"))
 		WRITE_DEADLINE = value;
 	else if (!strcmp(name, "READ_DEADLINE"))
@@ -247,9 +350,31 @@ void load_entry(char *name, double value, uint line_number) {
 		ENABLE_WEAR_LEVELING = value;
 	else if (!strcmp(name, "ENABLE_TAGGING"))
 		ENABLE_TAGGING = value;
-	else
+	else if (!strcmp(name, "USE_ERASE_QUEUE"))
+		USE_ERASE_QUEUE = value;
+	else if (!strcmp(name, "WEAR_LEVEL_THRESHOLD"))
+		WEAR_LEVEL_THRESHOLD = value;
+	else if (!strcmp(name, "MAX_ONGOING_WL_OPS"))
+		MAX_ONGOING_WL_OPS = value;
+	else if (!strcmp(name, "GARBAGE_COLLECTION_POLICY"))
+		GARBAGE_COLLECTION_POLICY = value;
+	else if (!strcmp(name, "SEQUENTIAL_LOCALITY_THRESHOLD"))
+		SEQUENTIAL_LOCALITY_THRESHOLD = value;
+	else if (!strcmp(name, "LOCALITY_PARALLEL_DEGREE"))
+		LOCALITY_PARALLEL_DEGREE = (uint) value;
+	else if (!strcmp(name, "FTL_DESIGN"))
+		FTL_DESIGN = value;
+	else if (!strcmp(name, "SRAM"))
+		SRAM = value;
+	else if (!strcmp(name, "PAGE_HOTNESS_MEASURER"))
+		PAGE_HOTNESS_MEASURER = value;
+	else if (!strcmp(name, "PRINT_LEVEL"))
+		PRINT_LEVEL = value;
+	else if (!load_ftl_entry(name, value)) {
 		fprintf(stderr, "Config file parsing error on line %u:  %s   %f\n", line_number, name, value);
-	return;
+		return false;
+	}
+	return true;
 }
 
 void set_small_SSD_config() {
@@ -379,15 +504,52 @@ void print_config(FILE *stream) {
 	fprintf(stream, "\tMAX_CONCURRENT_GC_OPS:\t%u\n", MAX_CONCURRENT_GC_OPS);
 	fprintf(stream, "\tMAX_REPEATED_COPY_BACKS_ALLOWED: %i\n", MAX_REPEATED_COPY_BACKS_ALLOWED);
 	fprintf(stream, "\tMAX_ITEMS_IN_COPY_BACK_MAP: %i\n\n", MAX_ITEMS_IN_COPY_BACK_MAP);
+	fprintf(stream, "\tGARBAGE_COLLECTION_POLICY: %i\n", GARBAGE_COLLECTION_POLICY);
+	fprintf(stream, "\tSEQUENTIAL_LOCALITY_THRESHOLD: %i\n", SEQUENTIAL_LOCALITY_THRESHOLD);
+	fprintf(stream, "\tLOCALITY_PARALLEL_DEGREE: %u\n", LOCALITY_PARALLEL_DEGREE);
+	fprintf(stream, "\tUSE_ERASE_QUEUE: %i\n", USE_ERASE_QUEUE);
+	fprintf(stream, "\tPAGE_HOTNESS_MEASURER: %i\n\n", PAGE_HOTNESS_MEASURER);
+	fprintf(stream, "\tSPECIALIZE_GEOMETRY: %i\n\n", SPECIALIZE_GEOMETRY);
 	fprintf(stream, "\tWRITE_DEADLINE: %i\n\n", WRITE_DEADLINE);
 	fprintf(stream, "\tREAD_DEADLINE: %i\n\n", READ_DEADLINE);
 	fprintf(stream, "\tENABLE_WEAR_LEVELING: %i\n\n", ENABLE_WEAR_LEVELING);
+	fprintf(stream, "\tWEAR_LEVEL_THRESHOLD: %i\n", WEAR_LEVEL_THRESHOLD);
+	fprintf(stream, "\tMAX_ONGOING_WL_OPS: %i\n\n", MAX_ONGOING_WL_OPS);
+
+	fprintf(stream, "#FTL:\n");
+	fprintf(stream, "\tFTL_DESIGN: %i\n", FTL_DESIGN);
+	fprintf(stream, "\tSRAM: %i\n", SRAM);
+	print_ftl_config(stream);
+	fprintf(stream, "\n");
 
 	fprintf(stream, "#Open Interface:\n");
 	fprintf(stream, "\tENABLE_TAGGING: %i\n\n", ENABLE_TAGGING);
 
 	fprintf(stream, "#Operating System:\n");
-	fprintf(stream, "\tOS_SCHEDULER: %i\n\n", OS_SCHEDULER);
+	fprintf(stream, "\tOS_SCHEDULER: %i\n", OS_SCHEDULER);
+	fprintf(stream, "\tOS_MAX_REQUEST_SIZE: %i\n", OS_MAX_REQUEST_SIZE);
+	fprintf(stream, "\tOS_PLUG_WINDOW: %f\n", OS_PLUG_WINDOW);
+	fprintf(stream, "\tPAGE_CACHE_SIZE: %i\n", PAGE_CACHE_SIZE);
+	fprintf(stream, "\tPAGE_CACHE_ACCESS_DELAY: %f\n", PAGE_CACHE_ACCESS_DELAY);
+	fprintf(stream, "\tPAGE_CACHE_DIRTY_RATIO: %f\n", PAGE_CACHE_DIRTY_RATIO);
+	fprintf(stream, "\tPAGE_CACHE_DIRTY_BACKGROUND_RATIO: %f\n", PAGE_CACHE_DIRTY_BACKGROUND_RATIO);
+	fprintf(stream, "\tPAGE_CACHE_WRITEBACK_BATCH: %i\n", PAGE_CACHE_WRITEBACK_BATCH);
+	fprintf(stream, "\tPAGE_CACHE_READAHEAD_MAX: %i\n\n", PAGE_CACHE_READAHEAD_MAX);
+
+	fprintf(stream, "#Steady State:\n");
+	fprintf(stream, "\tSTEADY_STATE_WINDOW: %i\n", STEADY_STATE_WINDOW);
+	fprintf(stream, "\tSTEADY_STATE_NUM_WINDOWS: %i\n", STEADY_STATE_NUM_WINDOWS);
+	fprintf(stream, "\tSTEADY_STATE_THROUGHPUT_TOLERANCE: %f\n", STEADY_STATE_THROUGHPUT_TOLERANCE);
+	fprintf(stream, "\tSTEADY_STATE_WRITE_AMPLIFICATION_TOLERANCE: %f\n", STEADY_STATE_WRITE_AMPLIFICATION_TOLERANCE);
+	fprintf(stream, "\tSTEADY_STATE_LATENCY_TOLERANCE: %f\n", STEADY_STATE_LATENCY_TOLERANCE);
+	fprintf(stream, "\tFAST_FORWARD_CALIBRATION: %i\n\n", FAST_FORWARD_CALIBRATION);
+
+	fprintf(stream, "#Sampling:\n");
+	fprintf(stream, "\tSAMPLING_PERIOD: %i\n", SAMPLING_PERIOD);
+	fprintf(stream, "\tSAMPLING_WARMUP: %i\n", SAMPLING_WARMUP);
+	fprintf(stream, "\tSAMPLING_WINDOW: %i\n", SAMPLING_WINDOW);
+	fprintf(stream, "\tSAMPLING_MIN_SAMPLES: %i\n", SAMPLING_MIN_SAMPLES);
+	fprintf(stream, "\tSAMPLING_TARGET_ERROR: %f\n\n", SAMPLING_TARGET_ERROR);
 
 	fprintf(stream, "#Scheduler:\n");
 	fprintf(stream, "\tALLOW_DEFERRING_TRANSFERS: %i\n", ALLOW_DEFERRING_TRANSFERS);
@@ -11,7 +11,7 @@ Die::Die(long physical_address):
 	last_read_io(UNDEFINED)
 {
 	for(uint i = 0; i < DIE_SIZE; i++) {
-		int a = physical_address + (PLANE_SIZE * BLOCK_SIZE * i);
+		long a = physical_address + ((long)PLANE_SIZE * BLOCK_SIZE * i);
 		Plane p = Plane(a);
 		data.push_back(p);
 	}
@@ -6,6 +6,7 @@ using namespace ssd;
 
 uint Event::id_generator = 0;
 uint Event::application_io_id_generator = 0;
+unordered_map<uint, Event::Cold_Fields> Event::cold_fields = unordered_map<uint, Event::Cold_Fields>();
 
 /* see "enum event_type" in ssd.h for details on event types
  * The logical address and size are both measured in flash pages
@@ -15,27 +16,26 @@ Event::Event(enum event_type type, ulong logical_address, uint size, double star
 	execution_time(0.0),
 	bus_wait_time(0.0),
 	os_wait_time(0.0),
-	type(type),
+	accumulated_wait_time(0),
+	pure_ssd_wait_time(0),
 	logical_address(logical_address),
+	type(type),
 	size(size),
-	payload(NULL),
-	//next(NULL),
-	noop(false),
 	id(id_generator++),
 	application_io_id(application_io_id_generator++),
+	ssd_id(UNDEFINED),
+	age_class(0),
+	tag(-1),
+	num_iterations_in_scheduler(0),
+	noop(false),
 	garbage_collection_op(false),
 	wear_leveling_op(false),
 	mapping_op(false),
 	original_application_io(false),
-	age_class(0),
-	tag(-1),
-	accumulated_wait_time(0),
-	thread_id(UNDEFINED),
-	pure_ssd_wait_time(0),
 	copyback(false),
 	cached_write(false),
-	num_iterations_in_scheduler(0),
-	ssd_id(UNDEFINED)
+	has_cold_fields(false),
+	zone_command(NO_ZONE_COMMAND)
 {
 
 	if (application_io_id == 1693276) {
@@ -43,8 +43,8 @@ Event::Event(enum event_type type, ulong logical_address, uint size, double star
 		i++;
 	}
 	assert(start_time >= 0.0);
-	if (logical_address > NUMBER_OF_ADDRESSABLE_BLOCKS() * BLOCK_SIZE) {
-		printf("invalid logical address, too big  %d   %d\n", logical_address, NUMBER_OF_ADDRESSABLE_BLOCKS() * BLOCK_SIZE);
+	if (logical_address > NUMBER_OF_ADDRESSABLE_PAGES()) {
+		printf("invalid logical address, too big  %lu   %lu\n", logical_address, NUMBER_OF_ADDRESSABLE_PAGES());
 		assert(false);
 	}
 }
@@ -54,34 +54,46 @@ Event::Event(Event const& event) :
 	execution_time(event.execution_time),
 	bus_wait_time(event.bus_wait_time),
 	os_wait_time(0.0),
-	type(event.type),
+	accumulated_wait_time(0),
+	pure_ssd_wait_time(event.pure_ssd_wait_time),
 	logical_address(event.logical_address),
+	type(event.type),
 	size(event.size),
-	payload(NULL),
-	//next(NULL),
-	noop(event.noop),
 	id(id_generator++),
 	application_io_id(event.application_io_id),
+	ssd_id(event.ssd_id),
+	age_class(event.age_class),
+	tag(event.tag),
+	num_iterations_in_scheduler(0),
+	noop(event.noop),
 	garbage_collection_op(event.garbage_collection_op),
 	wear_leveling_op(event.wear_leveling_op),
 	mapping_op(event.mapping_op),
 	original_application_io(event.original_application_io),
-	age_class(event.age_class),
-	tag(event.tag),
-	accumulated_wait_time(0),
-	thread_id(event.thread_id),
-	pure_ssd_wait_time(event.pure_ssd_wait_time),
 	copyback(event.copyback),
 	cached_write(event.cached_write),
-	num_iterations_in_scheduler(0),
-	ssd_id(event.ssd_id)
+	has_cold_fields(false),
+	zone_command(event.zone_command)
 {}
 
+Event::~Event() {
+	if (has_cold_fields) {
+		cold_fields.erase(id);
+	}
+}
+
+Event::Cold_Fields::Cold_Fields() : payload(NULL), thread_id(UNDEFINED) {}
+
+Event::Cold_Fields& Event::get_cold_fields() {
+	has_cold_fields = true;
+	return cold_fields[id];
+}
+
 bool Event::is_flexible_read() {
 	return dynamic_cast<Flexible_Read_Event*>(this) != NULL;
 }
 
-Event::Event() : type(NOT_VALID) {}
+Event::Event() : type(NOT_VALID), has_cold_fields(false), zone_command(NO_ZONE_COMMAND) {}
 
 void Event::print(FILE *stream) const
 {
@@ -105,17 +117,19 @@ void Event::print(FILE *stream) const
 		fprintf(stream, "GC ");
 	else if (type == COPY_BACK)
 		fprintf(stream, "CB ");
+	else if (type == FSYNC)
+		fprintf(stream, "F ");
 	else
 		fprintf(stream, "Unknown event type: ");
 
 	fprintf(stream, "%d\t", logical_address);
 	if (type != TRIM) {
-		address.print(stream);
+		get_address().print(stream);
 	} else {
-		replace_address.print(stream);
+		get_replace_address().print(stream);
 	}
 	if (type == WRITE) {
-		replace_address.print(stream);
+		get_replace_address().print(stream);
 	}
 	//if(type == MERGE)
 		//merge_address.print(stream);
@@ -128,8 +142,8 @@ void Event::print(FILE *stream) const
 	fprintf(stream, " ID: %d ", id);
 	fprintf(stream, " appID: %d", application_io_id);
 
-	if(thread_id != UNDEFINED) {
-		fprintf(stream, " thread: %d", thread_id);
+	if (has_cold_fields && cold_fields.at(id).thread_id != UNDEFINED) {
+		fprintf(stream, " thread: %d", cold_fields.at(id).thread_id);
 	}
 	if (garbage_collection_op) {
 		fprintf(stream, " GC");
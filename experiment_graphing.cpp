@@ -445,7 +445,7 @@ string Experiment::get_working_dir() {
 }
 
 void Experiment::draw_graphs() {
-	if (d_variable != NULL || i_variable != NULL) {
+	if (d_variable != NULL || i_variable != NULL || !grid_points.empty()) {
 		draw_aggregate_graphs();
 	}
 	draw_experiment_spesific_graphs();
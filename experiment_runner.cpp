@@ -27,6 +27,7 @@ string Experiment::base_folder = get_current_dir_name();
 Experiment::Experiment()
 	: d_variable(NULL), d_min(0), d_max(0), d_incr(0),
 	  i_variable(NULL), i_min(0), i_max(0), i_incr(0),
+	  grid_knob_names(), grid_points(),
 	  io_limit(NUMBER_OF_ADDRESSABLE_PAGES()),
 	  workload(NULL), calibration_workload(NULL),
 	  calibrate_for_each_point(false),
@@ -58,6 +59,15 @@ void Experiment::set_variable(int* variable, int low, int high, int incr, string
 	variable_name = name;
 }
 
+void Experiment::set_grid(vector<string> knob_names, vector<vector<double> > points) {
+	for (auto point : points) {
+		assert(point.size() == knob_names.size());
+	}
+	grid_knob_names = knob_names;
+	grid_points = points;
+	variable_name = "Grid point";
+}
+
 void Experiment::run(string name) {
 	Thread::set_record_internal_statistics(true);
 	StatisticsGatherer::set_record_statistics(true);
@@ -66,7 +76,10 @@ void Experiment::run(string name) {
 		fprintf(stderr, "The simulation parameter MAX_REPEATED_COPY_BACKS_ALLOWED is greater than 0. This is still buggy, and so we fail.\nSet this parameter to 0 to remove this error message.\n");
 	}
 
-	if (i_variable == NULL && d_variable == NULL) {
+	if (!grid_points.empty()) {
+		grid_experiment(name);
+	}
+	else if (i_variable == NULL && d_variable == NULL) {
 		run_single_point(name);
 	}
 	else if (d_variable != NULL) {
@@ -201,6 +214,68 @@ void Experiment::simple_experiment_double(string name, T* var, T min, T max, T i
 	results.push_back(result);
 }
 
+// Like simple_experiment_double, but every point sets several knobs. The points are numbered in the order they run,
+// and grid.csv in the experiment folder maps each number to the knob values of the point.
+void Experiment::grid_experiment(string name) {
+	string data_folder = base_folder + name + "/";
+	mkdir(data_folder.c_str(), 0755);
+	Experiment_Result global_result(name, data_folder, "Global/", variable_name);
+	global_result.start_experiment();
+
+	std::ofstream grid_file((data_folder + "grid.csv").c_str());
+	grid_file << "point";
+	for (auto knob_name : grid_knob_names) {
+		grid_file << ", " << knob_name;
+	}
+	grid_file << "\n";
+
+	for (uint point = 0; point < grid_points.size(); point++) {
+		stringstream point_description;
+		grid_file << point;
+		for (uint i = 0; i < grid_knob_names.size(); i++) {
+			load_entry(grid_knob_names[i].c_str(), grid_points[point][i], 0);
+			point_description << (i == 0 ? "" : ", ") << grid_knob_names[i] << " = " << grid_points[point][i];
+			grid_file << ", " << grid_points[point][i];
+		}
+		grid_file << "\n";
+		grid_file.flush();
+		printf("----------------------------------------------------------------------------------------------------------\n");
+		printf("%s :  point %u of %zu :  %s \n", name.c_str(), point, grid_points.size(), point_description.str().c_str());
+		printf("----------------------------------------------------------------------------------------------------------\n");
+
+		string point_folder_name = data_folder + to_string(point) + "/";
+		mkdir(point_folder_name.c_str(), 0755);
+		if (generate_trace_file) {
+			VisualTracer::init(point_folder_name);
+		} else {
+			VisualTracer::init();
+		}
+		write_config_file(point_folder_name);
+		Queue_Length_Statistics::init();
+		Free_Space_Meter::init();
+		Free_Space_Per_LUN_Meter::init();
+		Individual_Threads_Statistics::init();
+
+		OperatingSystem* os = calibration_file.empty() ? new OperatingSystem() : load_state(calibration_file);
+		if (workload != NULL) {
+			vector<Thread*> experiment_threads = workload->generate_instance();
+			os->set_threads(experiment_threads);
+		}
+		StatisticsGatherer::set_record_statistics(true);
+		os->set_num_writes_to_stop_after(io_limit);
+		os->run();
+		StatisticsGatherer::get_global_instance()->print();
+		global_result.collect_stats(to_string(point), StatisticsGatherer::get_global_instance());
+		StatisticData::init();
+		write_results_file(point_folder_name);
+		delete os;
+	}
+	global_result.end_experiment();
+	vector<Experiment_Result> result;
+	result.push_back(global_result);
+	results.push_back(result);
+}
+
 vector<Experiment_Result> Experiment::random_writes_on_the_side_experiment(Workload_Definition* workload, int write_threads_min, int write_threads_max, int write_threads_inc, string name, int IO_limit, double used_space, int random_writes_min_lba, int random_writes_max_lba) {
 	string data_folder = base_folder + name;
 	mkdir(data_folder.c_str(), 0755);
@@ -285,13 +360,13 @@ vector<Experiment_Result> Experiment::random_writes_on_the_side_experiment(Workl
     return results;
 }
 
-Experiment_Result Experiment::copyback_experiment(vector<Thread*> (*experiment)(int highest_lba), int used_space, int max_copybacks, string data_folder, string name, int IO_limit) {
+Experiment_Result Experiment::copyback_experiment(vector<Thread*> (*experiment)(long highest_lba), int used_space, int max_copybacks, string data_folder, string name, int IO_limit) {
     Experiment_Result experiment_result(name, data_folder, "", "CopyBacks allowed before ECC check");
     experiment_result.start_experiment();
 
-    const int num_pages = NUMBER_OF_ADDRESSABLE_BLOCKS() * BLOCK_SIZE;
+    const long num_pages = NUMBER_OF_ADDRESSABLE_PAGES();
     for (int copybacks_allowed = 0; copybacks_allowed <= max_copybacks; copybacks_allowed += 1) {
-		int highest_lba = (int) ((double) num_pages * used_space / 100);
+		long highest_lba = (long) ((double) num_pages * used_space / 100);
 		printf("---------------------------------------\n");
 		printf("Experiment with %d copybacks allowed.\n", copybacks_allowed);
 		printf("---------------------------------------\n");
@@ -324,13 +399,13 @@ Experiment_Result Experiment::copyback_experiment(vector<Thread*> (*experiment)(
 	return experiment_result;
 }
 
-Experiment_Result Experiment::copyback_map_experiment(vector<Thread*> (*experiment)(int highest_lba), int cb_map_min, int cb_map_max, int cb_map_inc, int used_space, string data_folder, string name, int IO_limit) {
+Experiment_Result Experiment::copyback_map_experiment(vector<Thread*> (*experiment)(long highest_lba), int cb_map_min, int cb_map_max, int cb_map_inc, int used_space, string data_folder, string name, int IO_limit) {
     Experiment_Result experiment_result(name, data_folder, "", "Max copyback map size");
     experiment_result.start_experiment();
 
-    const int num_pages = NUMBER_OF_ADDRESSABLE_BLOCKS() * BLOCK_SIZE;
+    const long num_pages = NUMBER_OF_ADDRESSABLE_PAGES();
     for (int copyback_map_size = cb_map_min; copyback_map_size <= cb_map_max; copyback_map_size += cb_map_inc) {
-		int highest_lba = (int) ((double) num_pages * used_space / 100);
+		long highest_lba = (long) ((double) num_pages * used_space / 100);
 		printf("-------------------------------------------------------\n");
 		printf("Experiment with %d copybacks allowed in copyback map.  \n", copyback_map_size);
 		printf("-------------------------------------------------------\n");
@@ -378,8 +453,12 @@ void Experiment::calibrate_and_save(Workload_Definition* workload, string name,
 	VisualTracer::init();
 	//Free_Space_Meter::init();
 	//Free_Space_Per_LUN_Meter::init();
-	printf("Creating calibrated SSD state.\n");
 	OperatingSystem* os = new OperatingSystem();
+	// With fast forwarding, the calibration workload is executed functionally, which is much faster than timing every IO
+	IOScheduler* scheduler = os->get_ssd()->get_scheduler();
+	bool fast_forward = FAST_FORWARD_CALIBRATION && scheduler->can_fast_forward();
+	printf("Creating calibrated SSD state%s.\n", fast_forward ? " by fast forwarding" : "");
+	scheduler->set_fast_forward(fast_forward);
 	//num_IOs /= 2;
 	os->set_num_writes_to_stop_after(num_IOs);
 	vector<Thread*> init_threads = workload->generate_instance();
@@ -387,6 +466,7 @@ void Experiment::calibrate_and_save(Workload_Definition* workload, string name,
 	os->set_progress_meter_granularity(1000);
 
 	os->run();
+	scheduler->set_fast_forward(false);
 	os->get_ssd()->execute_all_remaining_events();
 
 	//Block_Manager_Tag_Groups* bm = (Block_Manager_Tag_Groups*) os->get_ssd()->get_scheduler()->get_bm();
@@ -416,6 +496,8 @@ void Experiment::write_results_file(string folder_name) {
 	fprintf(file, "channel util:\t%f\n", channel_util);
 	double LUN_util = Utilization_Meter::get_avg_LUN_utilization();
 	fprintf(file, "LUN util:\t%f\n\n", LUN_util);
+	Steady_State_Monitor::print(file);
+	Sampled_Simulation::print(file);
 
 	for (int i = 0; i < SSD_SIZE; i++) {
 		fprintf(file, "Channel util for package %d:\t%f\n", i, Utilization_Meter::get_channel_utilization(i) );
@@ -436,6 +518,17 @@ void Experiment::write_results_file(string folder_name) {
 			fprintf(file, "Thread writes %d: %d\n", i, num_writes);
 		}
 	}
+	fprintf(file, "\n");
+
+	// Latency and throughput per thread, e.g. to tell the commit latency of a log writer apart from the throughput of background writers
+	for (int i = 0; i < Individual_Threads_Statistics::size(); i++) {
+		StatisticsGatherer* sg = Individual_Threads_Statistics::get_stats_for_thread(i);
+		if (sg != NULL) {
+			fprintf(file, "Statistics for thread %d: %s\n", i, Individual_Threads_Statistics::get_thread_name(i).c_str());
+			sg->print_simple(file);
+			fprintf(file, "\n");
+		}
+	}
 
 	fclose(file);
 }
@@ -0,0 +1,203 @@
+/*
+ * experiment_spec.cpp
+ *
+ *  Parses experiment spec files, and runs the grid of points they describe.
+ */
+
+#include "ssd.h"
+using namespace ssd;
+
+Experiment_Spec::Experiment_Spec(string file_name)
+	: name("experiment"),
+	  io_limit(UNDEFINED),
+	  workload(NULL),
+	  precondition(false),
+	  is_cartesian(true),
+	  draw_graphs(false),
+	  knob_names(),
+	  knob_values()
+{
+	parse(file_name);
+}
+
+Experiment_Spec::~Experiment_Spec() {
+	delete workload;
+}
+
+static double parse_number(string const& text, int line_number) {
+	char* end = NULL;
+	double number = strtod(text.c_str(), &end);
+	if (text.empty() || *end != '\0') {
+		fprintf(stderr, "Experiment spec parsing error on line %d: %s is not a number.  Exiting.\n", line_number, text.c_str());
+		exit(FILE_ERR);
+	}
+	return number;
+}
+
+void Experiment_Spec::parse(string file_name) {
+	std::ifstream file(file_name.c_str());
+	if (!file) {
+		fprintf(stderr, "Experiment spec %s not found.  Exiting.\n", file_name.c_str());
+		exit(FILE_ERR);
+	}
+	string line;
+	for (int line_number = 1; getline(file, line); line_number++) {
+		line = line.substr(0, line.find('#'));
+		stringstream line_stream(line);
+		vector<string> tokens;
+		for (string token; line_stream >> token; ) {
+			tokens.push_back(token);
+		}
+		if (tokens.empty()) {
+			continue;
+		}
+		string directive = tokens[0];
+		vector<string> arguments(tokens.begin() + 1, tokens.end());
+		if (arguments.empty()) {
+			fprintf(stderr, "Experiment spec parsing error on line %d: %s has no value.  Exiting.\n", line_number, directive.c_str());
+			exit(FILE_ERR);
+		}
+		if (directive == "name") {
+			name = arguments[0];
+		} else if (directive == "io_limit") {
+			io_limit = parse_number(arguments[0], line_number);
+		} else if (directive == "workload") {
+			delete workload;
+			workload = create_workload(arguments, line_number);
+		} else if (directive == "precondition") {
+			precondition = parse_number(arguments[0], line_number);
+		} else if (directive == "draw_graphs") {
+			draw_graphs = parse_number(arguments[0], line_number);
+		} else if (directive == "sweep") {
+			if (arguments[0] != "cartesian" && arguments[0] != "zip") {
+				fprintf(stderr, "Experiment spec parsing error on line %d: the sweep must be cartesian or zip.  Exiting.\n", line_number);
+				exit(FILE_ERR);
+			}
+			is_cartesian = arguments[0] == "cartesian";
+		} else if (directive == "vary") {
+			if (arguments.size() < 2) {
+				fprintf(stderr, "Experiment spec parsing error on line %d: %s has no values to vary over.  Exiting.\n", line_number, arguments[0].c_str());
+				exit(FILE_ERR);
+			}
+			vector<double> values;
+			for (uint i = 1; i < arguments.size(); i++) {
+				values.push_back(parse_number(arguments[i], line_number));
+			}
+			// Setting the knob checks that it exists. It is set again at every point.
+			if (!load_entry(arguments[0].c_str(), values[0], line_number)) {
+				exit(FILE_ERR);
+			}
+			knob_names.push_back(arguments[0]);
+			knob_values.push_back(values);
+		} else if (arguments.size() != 1 || !load_entry(directive.c_str(), parse_number(arguments[0], line_number), line_number)) {
+			fprintf(stderr, "Experiment spec parsing error on line %d: %s.  Exiting.\n", line_number, line.c_str());
+			exit(FILE_ERR);
+		}
+	}
+	if (workload == NULL) {
+		fprintf(stderr, "Experiment spec %s has no workload.  Exiting.\n", file_name.c_str());
+		exit(FILE_ERR);
+	}
+	for (auto values : knob_values) {
+		if (!is_cartesian && values.size() != knob_values[0].size()) {
+			fprintf(stderr, "Experiment spec %s: a zip sweep needs the same number of values for every variable.  Exiting.\n", file_name.c_str());
+			exit(FILE_ERR);
+		}
+	}
+	if (precondition) {
+		workload = new Preconditioned_Workload(workload);
+	}
+}
+
+// The workloads and their arguments, all of which are optional except for the fio job file:
+//   init_write
+//   init_random_writes
+//   random [number of threads]
+//   asynch_random [write probability]
+//   synch_random
+//   synch_write
+//   file_system_with_noise
+//   grace_hash_join
+//   lsm [file size] [level fanout] [write rate]
+//   oltp [dirty page rate] [checkpoint interval] [number of readers]
+//   fio <job file>
+Workload_Definition* Experiment_Spec::create_workload(vector<string> const& arguments, int line_number) {
+	string workload_name = arguments[0];
+	auto argument = [&](uint index, double default_value) {
+		return index < arguments.size() ? parse_number(arguments[index], line_number) : default_value;
+	};
+	if (workload_name == "init_write") {
+		return new Init_Write();
+	} else if (workload_name == "init_random_writes") {
+		return new Init_Workload();
+	} else if (workload_name == "random") {
+		return new Random_Workload(argument(1, 1));
+	} else if (workload_name == "asynch_random") {
+		return new Asynch_Random_Workload(argument(1, 0.5));
+	} else if (workload_name == "synch_random") {
+		return new Synch_Random_Workload();
+	} else if (workload_name == "synch_write") {
+		return new Synch_Write();
+	} else if (workload_name == "file_system_with_noise") {
+		return new File_System_With_Noise();
+	} else if (workload_name == "grace_hash_join") {
+		return new Grace_Hash_Join_Workload();
+	} else if (workload_name == "lsm") {
+		return new LSM_Compaction_Workload(argument(1, 64), argument(2, 10), argument(3, UNDEFINED));
+	} else if (workload_name == "oltp") {
+		return new OLTP_Workload(argument(1, 5000), argument(2, 100000), argument(3, 4));
+	} else if (workload_name == "fio" && arguments.size() == 2) {
+		return new Fio_Workload(arguments[1]);
+	}
+	fprintf(stderr, "Experiment spec parsing error on line %d: unknown workload %s.  Exiting.\n", line_number, workload_name.c_str());
+	exit(FILE_ERR);
+}
+
+// In a cartesian sweep, the last variable changes fastest
+vector<vector<double> > Experiment_Spec::get_points() const {
+	vector<vector<double> > points;
+	if (knob_names.empty()) {
+		return points;
+	}
+	if (!is_cartesian) {
+		for (uint i = 0; i < knob_values[0].size(); i++) {
+			vector<double> point;
+			for (auto values : knob_values) {
+				point.push_back(values[i]);
+			}
+			points.push_back(point);
+		}
+		return points;
+	}
+	vector<uint> indices(knob_names.size(), 0);
+	while (true) {
+		vector<double> point;
+		for (uint i = 0; i < knob_names.size(); i++) {
+			point.push_back(knob_values[i][indices[i]]);
+		}
+		points.push_back(point);
+		int variable = knob_names.size() - 1;
+		while (variable >= 0 && ++indices[variable] == knob_values[variable].size()) {
+			indices[variable--] = 0;
+		}
+		if (variable < 0) {
+			return points;
+		}
+	}
+}
+
+// Without any sweep variables, the experiment is a single point
+void Experiment_Spec::run() {
+	Experiment experiment;
+	experiment.set_workload(workload);
+	if (io_limit != UNDEFINED) {
+		experiment.set_io_limit(io_limit);
+	}
+	if (!knob_names.empty()) {
+		experiment.set_grid(knob_names, get_points());
+	}
+	experiment.run(name);
+	if (draw_graphs) {
+		experiment.draw_graphs();
+	}
+}
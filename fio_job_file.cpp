@@ -0,0 +1,248 @@
+/*
+ * fio_job_file.cpp
+ *
+ *  Parses fio job files into workloads, and reports their results in fio's JSON format.
+ */
+
+#include "ssd.h"
+using namespace ssd;
+
+const set<string> Fio_Workload::supported_options = {
+	"rw", "readwrite", "rwmixread", "rwmixwrite", "bs", "blocksize", "iodepth", "numjobs", "size", "offset",
+	"rate_iops", "runtime", "time_based", "number_ios", "random_distribution", "randseed", "group_reporting"
+};
+
+// Options that only concern the host side of fio, and so have nothing to map onto in the simulator
+const set<string> Fio_Workload::ignored_options = {
+	"name", "description", "filename", "directory", "ioengine", "direct", "buffered", "thread", "invalidate",
+	"norandommap", "randrepeat", "stonewall", "new_group", "ramp_time", "output-format", "lat_percentiles", "clat_percentiles"
+};
+
+static string trim_whitespace(string const& text) {
+	size_t first = text.find_first_not_of(" \t\r\n");
+	if (first == string::npos) {
+		return "";
+	}
+	size_t last = text.find_last_not_of(" \t\r\n");
+	return text.substr(first, last - first + 1);
+}
+
+Fio_Workload::Fio_Workload(string job_file_name)
+	: Workload_Definition(),
+	  jobs(),
+	  statistics()
+{
+	parse(job_file_name);
+}
+
+Fio_Workload::~Fio_Workload() {
+	for (auto entry : statistics) {
+		delete entry.second;
+	}
+}
+
+// The [global] section sets defaults for the job sections after it, like in fio
+void Fio_Workload::parse(string job_file_name) {
+	std::ifstream file(job_file_name.c_str());
+	if (!file) {
+		fprintf(stderr, "fio job file %s not found.  Exiting.\n", job_file_name.c_str());
+		exit(FILE_ERR);
+	}
+	map<string, string> global_options;
+	bool in_global_section = false;
+	string line;
+	for (int line_number = 1; getline(file, line); line_number++) {
+		line = trim_whitespace(line);
+		if (line.empty() || line[0] == '#' || line[0] == ';') {
+			continue;
+		}
+		if (line[0] == '[' && line[line.size() - 1] == ']') {
+			string section = trim_whitespace(line.substr(1, line.size() - 2));
+			in_global_section = section == "global";
+			if (!in_global_section) {
+				Fio_Job job;
+				job.name = section;
+				job.options = global_options;
+				jobs.push_back(job);
+			}
+			continue;
+		}
+		size_t equals = line.find('=');
+		string option = trim_whitespace(line.substr(0, equals));
+		string value = equals == string::npos ? "" : trim_whitespace(line.substr(equals + 1));
+		if (!in_global_section && jobs.empty()) {
+			fprintf(stderr, "fio job file parsing error on line %d: option %s is outside of any section.  Exiting.\n", line_number, option.c_str());
+			exit(FILE_ERR);
+		}
+		if (ignored_options.count(option) == 1) {
+			continue;
+		}
+		if (supported_options.count(option) == 0) {
+			fprintf(stderr, "fio job file line %d: option %s is not supported, and is ignored\n", line_number, option.c_str());
+			continue;
+		}
+		if (in_global_section) {
+			global_options[option] = value;
+		} else {
+			jobs.back().options[option] = value;
+		}
+	}
+	if (jobs.empty()) {
+		fprintf(stderr, "fio job file %s has no jobs.  Exiting.\n", job_file_name.c_str());
+		exit(FILE_ERR);
+	}
+}
+
+// Sizes are in bytes, with optional k, m, g or t suffixes in powers of 1024 like fio's default kb_base,
+// or a percentage of the logical address space
+long Fio_Workload::parse_size(Fio_Job const& job, string option, long default_value) const {
+	if (!job.has(option)) {
+		return default_value;
+	}
+	string value = job.get(option, "");
+	char* suffix = NULL;
+	double number = strtod(value.c_str(), &suffix);
+	string unit = suffix;
+	transform(unit.begin(), unit.end(), unit.begin(), ::tolower);
+	if (unit == "%") {
+		return (long)(number / 100 * (max_lba - min_lba + 1)) * PAGE_SIZE;
+	}
+	const string units = "kmgt";
+	double multiplier = 1;
+	if (!unit.empty() && units.find(unit[0]) != string::npos) {
+		for (size_t i = 0; i <= units.find(unit[0]); i++) {
+			multiplier *= 1024;
+		}
+		unit = unit.substr(1);
+	}
+	if (suffix == value.c_str() || !(unit.empty() || unit == "b" || unit == "ib")) {
+		fprintf(stderr, "fio job %s: cannot parse %s=%s.  Exiting.\n", job.name.c_str(), option.c_str(), value.c_str());
+		exit(FILE_ERR);
+	}
+	return (long)(number * multiplier);
+}
+
+// Times are in seconds by default, like in fio
+double Fio_Workload::parse_time(Fio_Job const& job, string option) {
+	if (!job.has(option)) {
+		return UNDEFINED;
+	}
+	string value = job.get(option, "");
+	char* suffix = NULL;
+	double number = strtod(value.c_str(), &suffix);
+	string unit = suffix;
+	double multiplier = 0;
+	if (unit.empty() || unit == "s") multiplier = 1000000;
+	else if (unit == "ms") multiplier = 1000;
+	else if (unit == "us") multiplier = 1;
+	else if (unit == "m") multiplier = 60 * 1000000.0;
+	else if (unit == "h") multiplier = 3600 * 1000000.0;
+	if (suffix == value.c_str() || multiplier == 0) {
+		fprintf(stderr, "fio job %s: cannot parse %s=%s.  Exiting.\n", job.name.c_str(), option.c_str(), value.c_str());
+		exit(FILE_ERR);
+	}
+	return number * multiplier;
+}
+
+// Each clone of a job gets its own thread and random seed. Without number_ios, a job does one pass over its region
+// like in fio, unless it is time_based.
+vector<Thread*> Fio_Workload::generate() {
+	for (auto entry : statistics) {
+		delete entry.second;
+	}
+	statistics.clear();
+	vector<Thread*> threads;
+	long total_bytes = (max_lba - min_lba + 1) * PAGE_SIZE;
+	for (uint job_index = 0; job_index < jobs.size(); job_index++) {
+		Fio_Job const& job = jobs[job_index];
+		string rw = job.get("rw", job.get("readwrite", "read"));
+		rw = rw.substr(0, rw.find(':'));
+		bool is_random = rw.compare(0, 4, "rand") == 0;
+		string mode = is_random ? rw.substr(4) : rw;
+		if (mode != "read" && mode != "write" && mode != "trim" && mode != "rw" && mode != "readwrite") {
+			fprintf(stderr, "fio job %s: rw=%s is not supported.  Exiting.\n", job.name.c_str(), rw.c_str());
+			exit(FILE_ERR);
+		}
+		double write_probability = job.has("rwmixwrite") ? atof(job.get("rwmixwrite", "").c_str()) / 100 : 1 - atof(job.get("rwmixread", "50").c_str()) / 100;
+
+		long block_bytes = parse_size(job, job.has("bs") ? "bs" : "blocksize", 4096);
+		int block_size = max(1L, block_bytes / PAGE_SIZE);
+		if (block_bytes % PAGE_SIZE != 0) {
+			fprintf(stderr, "fio job %s: the block size is rounded to %d pages of %u bytes\n", job.name.c_str(), block_size, PAGE_SIZE);
+		}
+		long offset = min(parse_size(job, "offset", 0), total_bytes - PAGE_SIZE);
+		long size = min(parse_size(job, "size", total_bytes - offset), total_bytes - offset);
+		long first_LBA = min_lba + offset / PAGE_SIZE;
+		long num_blocks = size / PAGE_SIZE / block_size;
+		if (num_blocks == 0) {
+			fprintf(stderr, "fio job %s: the region is smaller than one block.  Exiting.\n", job.name.c_str());
+			exit(FILE_ERR);
+		}
+
+		int iodepth = atoi(job.get("iodepth", "1").c_str());
+		int num_clones = atoi(job.get("numjobs", "1").c_str());
+		double rate_iops = job.has("rate_iops") ? atof(job.get("rate_iops", "").c_str()) : UNDEFINED;
+		double runtime = parse_time(job, "runtime");
+		long num_IOs = num_blocks;
+		if (job.has("number_ios")) {
+			num_IOs = atol(job.get("number_ios", "").c_str());
+		} else if (job.has("time_based") && job.get("time_based", "1") != "0" && runtime != UNDEFINED) {
+			num_IOs = INFINITE;
+		}
+		string distribution = job.get("random_distribution", "random");
+		string distribution_name = distribution.substr(0, distribution.find(':'));
+		double distribution_parameter = distribution.find(':') == string::npos ? 0 : atof(distribution.substr(distribution.find(':') + 1).c_str());
+		ulong seed = job.has("randseed") ? atol(job.get("randseed", "").c_str()) : 0x89 + job_index * 7919;
+
+		Fio_Job_Statistics* shared_statistics = NULL;
+		if (job.has("group_reporting")) {
+			shared_statistics = new Fio_Job_Statistics(job.name);
+			statistics.push_back(pair<int, Fio_Job_Statistics*>(job_index, shared_statistics));
+		}
+		for (int clone = 0; clone < num_clones; clone++) {
+			ulong clone_seed = seed + clone * 104729;
+			IO_Pattern* pattern;
+			if (!is_random) {
+				pattern = new Sequential_IO_Pattern(0, num_blocks - 1);
+			} else if (distribution_name == "zipf") {
+				pattern = new Zipf_IO_Pattern(0, num_blocks - 1, distribution_parameter, clone_seed);
+			} else if (distribution_name == "pareto") {
+				pattern = new Pareto_IO_Pattern(0, num_blocks - 1, distribution_parameter, clone_seed);
+			} else if (distribution_name == "random") {
+				pattern = new Random_IO_Pattern(0, num_blocks - 1, clone_seed);
+			} else {
+				fprintf(stderr, "fio job %s: random_distribution=%s is not supported.  Exiting.\n", job.name.c_str(), distribution.c_str());
+				exit(FILE_ERR);
+			}
+			IO_Mode_Generator* type_generator;
+			if (mode == "read") {
+				type_generator = new READS();
+			} else if (mode == "write") {
+				type_generator = new WRITES();
+			} else if (mode == "trim") {
+				type_generator = new TRIMS();
+			} else {
+				type_generator = new READS_OR_WRITES(clone_seed, write_probability);
+			}
+			Fio_Job_Statistics* clone_statistics = shared_statistics;
+			if (clone_statistics == NULL) {
+				clone_statistics = new Fio_Job_Statistics(job.name);
+				statistics.push_back(pair<int, Fio_Job_Statistics*>(job_index, clone_statistics));
+			}
+			threads.push_back(new Fio_Thread(pattern, type_generator, first_LBA, block_size, iodepth, num_IOs, runtime, rate_iops, clone_statistics));
+		}
+	}
+	return threads;
+}
+
+void Fio_Workload::print_json(FILE* stream) const {
+	fprintf(stream, "{\n");
+	fprintf(stream, "  \"fio version\" : \"eagletree\",\n");
+	fprintf(stream, "  \"jobs\" : [\n");
+	for (uint i = 0; i < statistics.size(); i++) {
+		statistics[i].second->print_json(stream, jobs[statistics[i].first].options);
+		fprintf(stream, "%s\n", i == statistics.size() - 1 ? "" : ",");
+	}
+	fprintf(stream, "  ]\n");
+	fprintf(stream, "}\n");
+}
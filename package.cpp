@@ -10,7 +10,7 @@ Package::Package(long physical_address):
 	currently_executing_operation_finish_time(0)
 {
 	for(uint i = 0; i < PACKAGE_SIZE; i++) {
-		int a = physical_address + (DIE_SIZE * PLANE_SIZE * BLOCK_SIZE * i);
+		long a = physical_address + ((long)DIE_SIZE * PLANE_SIZE * BLOCK_SIZE * i);
 		Die p = Die(a);
 		data.push_back(p);
 	}
@@ -167,7 +167,7 @@ void Simple_Page_Hotness_Measurer::register_event(Event const& event) {
 
 void Simple_Page_Hotness_Measurer::start_new_interval_writes() {
 	average_write_hotness = 0;
-	for( uint addr = 0; addr < NUMBER_OF_ADDRESSABLE_BLOCKS() * BLOCK_SIZE; addr++  )
+	for( ulong addr = 0; addr < NUMBER_OF_ADDRESSABLE_PAGES(); addr++  )
 	{
 	    uint count = write_current_count[addr];
 	    write_moving_average[addr] = write_moving_average[addr] * WEIGHT + count * (1 - WEIGHT);
@@ -196,7 +196,7 @@ void Simple_Page_Hotness_Measurer::start_new_interval_writes() {
 
 void Simple_Page_Hotness_Measurer::start_new_interval_reads() {
 	average_read_hotness = 0;
-	for( uint addr = 0; addr < NUMBER_OF_ADDRESSABLE_BLOCKS() * BLOCK_SIZE; addr++  )
+	for( ulong addr = 0; addr < NUMBER_OF_ADDRESSABLE_PAGES(); addr++  )
 	{
 	    uint count = read_current_count[addr];
 	    read_moving_average[addr] = read_moving_average[addr] * WEIGHT + count * (1 - WEIGHT);
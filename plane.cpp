@@ -9,7 +9,7 @@ Plane::Plane(long physical_address) : data()
 {
 	for(uint i = 0; i < PLANE_SIZE; i++)
 	{
-		int address = physical_address + ( i * BLOCK_SIZE);
+		long address = physical_address + ((long)i * BLOCK_SIZE);
 		Block b = Block(address);
 		data.push_back(b);
 	}
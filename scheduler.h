@@ -13,6 +13,8 @@
 
 namespace ssd {
 
+class Fast_Forwarder;
+
 class Priorty_Scheme {
 public:
 	Priorty_Scheme(IOScheduler* scheduler) : scheduler(scheduler), queue(NULL) {}
@@ -146,6 +148,8 @@ public:
 	void schedule_events_queue(deque<Event*> events);
 	void schedule_event(Event* event);
 	bool is_empty();
+	bool is_idle();
+	double get_next_event_time();
 	void execute_soonest_events();
 	void handle(vector<Event*>& events);
 	void handle(Event* event);
@@ -163,6 +167,9 @@ public:
     Block_manager_parent* get_bm() { return bm; }
     void set_block_manager(Block_manager_parent* b) {bm = b;}
     Migrator* get_migrator() { return migrator; }
+    void set_fast_forward(bool fast_forward);
+    bool is_fast_forwarding() const { return fast_forwarder != NULL; }
+    bool can_fast_forward() const;
 private:
 	void setup_structures(deque<Event*> events);
 	enum status execute_next(Event* event);
@@ -196,9 +203,9 @@ private:
 	Block_manager_parent* bm;
 	Migrator* migrator;
 
-	unordered_map<uint, uint> dependency_code_to_LBA;
+	unordered_map<uint, ulong> dependency_code_to_LBA;
 	unordered_map<uint, event_type> dependency_code_to_type;
-	unordered_map<uint, uint> LBA_currently_executing;
+	unordered_map<ulong, uint> LBA_currently_executing;
 	unordered_map<uint, queue<uint> > op_code_to_dependent_op_codes;
 
 	struct Safe_Cache {
@@ -242,6 +249,47 @@ private:
 	void make_dependent(Event* dependent_event, uint independent_code);
 	double get_current_time() const;
 	void try_to_put_in_safe_cache(Event* write);
+
+	// While fast forwarding, all events go to the fast forwarder instead
+	Fast_Forwarder* fast_forwarder;
+};
+
+// Executes the events sent to the scheduler functionally, with no timing model. Each IO takes effect on the flash state
+// as soon as it is executed, through the same FTL, block manager, GC and migrator logic as in the timed simulation,
+// and the GC operations and erases it triggers run to completion before the next application IO.
+// This is used to drive the SSD to steady state quickly before a timed experiment. Only page mapping FTLs are supported,
+// since the other FTLs issue their own mapping and merge IOs.
+// The block managers spread writes over the LUNs with the shortest queues, so the fast forwarder keeps the finish time of each die
+// as a count of the flash time spent on it, and restores the real finish times once it is done.
+class Fast_Forwarder {
+public:
+	Fast_Forwarder(Ssd*, FtlParent*, Block_manager_parent*, Migrator*);
+	~Fast_Forwarder();
+	void schedule_event(Event* event);
+	bool is_empty() const { return application_events.empty() && internal_events.empty(); }
+	bool is_idle() const { return is_empty() && completed_events.empty(); }
+	double get_next_event_time() const;
+	void execute_soonest_events();
+private:
+	void execute_internal_events();
+	void execute_write(Event* write);
+	void execute_read(Event* read);
+	void execute_trim(Event* trim);
+	void execute_erase(Event* erase);
+	void execute_garbage_collection(Event* gc_event);
+	void execute_migration(deque<Event*> migration);
+	void occupy_die(Address const& address, double duration);
+	Block* get_block(Address const& address);
+
+	Ssd* ssd;
+	FtlParent* ftl;
+	Block_manager_parent* bm;
+	Migrator* migrator;
+	deque<Event*> application_events;
+	deque<Event*> internal_events;  // GC operations and erases
+	deque<Event*> completed_events;
+	vector<vector<double> > die_finish_times;  // before fast forwarding
+	long num_erases;
 };
 
 }
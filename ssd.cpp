@@ -20,8 +20,10 @@ Ssd::Ssd():
 	large_events_map(),
 	ftl(NULL)
 {
+	Address_Geometry::init();
+	Geometry_Dispatch::init();
 	for(uint i = 0; i < SSD_SIZE; i++) {
-		int a = PACKAGE_SIZE * DIE_SIZE * PLANE_SIZE * BLOCK_SIZE * i;
+		long a = (long)PACKAGE_SIZE * DIE_SIZE * PLANE_SIZE * BLOCK_SIZE * i;
 		Package p = Package(a);
 		data.push_back(p);
 	}
@@ -29,6 +31,8 @@ Ssd::Ssd():
 	int sram_allocation = SRAM;
 
 	StatisticsGatherer::init();
+	Steady_State_Monitor::init();
+	Sampled_Simulation::init();
 	Block_manager_parent* bm = Block_manager_parent::get_new_instance();
 	Garbage_Collector* gc = NULL;
 	Migrator* migrator = new Migrator();
@@ -38,6 +42,8 @@ Ssd::Ssd():
 		case 0: ftl = new FtlImpl_Page(this, bm); break;
 		case 1: ftl = new DFTL(this, bm); break;
 		case 2: ftl = new FAST(this, bm, migrator); break;
+		case 4: ftl = new HMB_FTL(this, bm); break;
+		case 5: ftl = new ZNS_FTL(this, bm, migrator); break;
 		default: ftl = new FtlImpl_Page(this, bm); break;
 		}
 	}
@@ -47,10 +53,15 @@ Ssd::Ssd():
 	Free_Space_Meter::init();
 	Free_Space_Per_LUN_Meter::init();
 
+	// Zoned devices do no garbage collection. The greedy collector only considers blocks with invalidated pages,
+	// and the ZNS FTL never invalidates a page, so it never finds a victim.
+	// The superblock BM only frees whole superblocks, so its victims must be whole superblocks too.
 	if (gc == NULL) {
-		switch (GARBAGE_COLLECTION_POLICY) {
+		int gc_policy = FTL_DESIGN == 5 ? 0 : BLOCK_MANAGER_ID == 8 ? 2 : GARBAGE_COLLECTION_POLICY;
+		switch (gc_policy) {
 		case 0: gc = new Garbage_Collector_Greedy(this, bm); break;
 		case 1: gc = new Garbage_Collector_LRU(this, bm); break;
+		case 2: gc = new Garbage_Collector_Superblock(this, bm); break;
 		default: gc = new Garbage_Collector_Greedy(this, bm); break;
 		}
 	}
@@ -96,17 +107,17 @@ void Ssd::submit(Event* event) {
 
 	// If the IO spans several flash pages, we break it into multiple flash page IOs
 	// When these page IOs are all finished, we return to the OS
+	// Tagged IOs are not broken up, since for them the size is a hint about the size of the whole tagged write
+	// Each page IO gets its own application IO ID, so that it does not collide with the IDs of other application IOs
 	static int ssd_id_generator = 0;
 	if (event->get_size() > 1 && event->get_tag() == UNDEFINED) {
 		int ssd_id = ssd_id_generator++;
 		event->set_ssd_id(ssd_id);
 		large_events_map.resiger_large_event(event);
-		for (int i = 0; i < event->get_size(); i++) {
-			Event* e = new Event(*event);
-			e->set_application_io_id(ssd_id_generator++);
+		for (uint i = 0; i < event->get_size(); i++) {
+			Event* e = new Event(event->get_event_type(), event->get_logical_address() + i, 1, event->get_ssd_submission_time());
+			e->set_original_application_io(true);
 			e->set_ssd_id(ssd_id);
-			e->set_size(1);
-			e->set_logical_address(event->get_logical_address() + i);
 			submit_to_ftl(e);
 		}
 	}
@@ -152,6 +163,15 @@ void Ssd::progress_since_os_is_waiting() {
 	scheduler->execute_soonest_events();
 }
 
+// The SSD is idle if it has no events left to execute and no completed application IOs left to return to the OS
+bool Ssd::is_idle() {
+	return scheduler->is_idle();
+}
+
+double Ssd::get_next_event_time() {
+	return scheduler->get_next_event_time();
+}
+
 void Ssd::register_event_completion(Event * event) {
 	if (event->is_original_application_io() && !event->get_noop() && !event->is_cached_write() && (event->get_event_type() == WRITE || event->get_event_type() == READ_TRANSFER)) {
 		last_io_submission_time = max(last_io_submission_time, event->get_ssd_submission_time());
@@ -12,6 +12,7 @@
 #include <stack>
 #include <queue>
 #include <deque>
+#include <list>
 #include <map>
 #include <unordered_map>
 #include <unordered_set>
@@ -27,6 +28,7 @@
 #include <boost/serialization/base_object.hpp>
 #include <sstream>
 #include <initializer_list>
+#include <coroutine>
 #include <boost/archive/xml_iarchive.hpp>
 #include <boost/archive/xml_oarchive.hpp>
 
@@ -67,7 +69,9 @@ namespace ssd {
 /* Simulator configuration from ssd_config.cpp */
 
 /* Configuration file parsing for extern config variables defined below */
-void load_entry(char *name, double value, uint line_number);
+bool load_entry(const char *name, double value, uint line_number);
+bool load_ftl_entry(const char *name, double value);
+void print_ftl_config(FILE *stream);
 void load_config(const char * const file_name);
 void set_big_SSD_config();
 void set_small_SSD_config();
@@ -152,12 +156,13 @@ extern const uint FTL_IMPLEMENTATION;
 //extern const uint VIRTUAL_PAGE_SIZE;
 
 // extern const uint NUMBER_OF_ADDRESSABLE_BLOCKS;
-static inline uint NUMBER_OF_ADDRESSABLE_BLOCKS() {
-	return SSD_SIZE * PACKAGE_SIZE * DIE_SIZE * PLANE_SIZE;
+// These are 64 bit, since a multi-terabyte SSD has more than 2^32 pages
+static inline ulong NUMBER_OF_ADDRESSABLE_BLOCKS() {
+	return (ulong)SSD_SIZE * PACKAGE_SIZE * DIE_SIZE * PLANE_SIZE;
 }
 
-static inline uint NUMBER_OF_ADDRESSABLE_PAGES() {
-	return SSD_SIZE * PACKAGE_SIZE * DIE_SIZE * PLANE_SIZE * BLOCK_SIZE;
+static inline ulong NUMBER_OF_ADDRESSABLE_PAGES() {
+	return NUMBER_OF_ADDRESSABLE_BLOCKS() * BLOCK_SIZE;
 }
 
 /*
@@ -199,6 +204,38 @@ extern uint MAX_ITEMS_IN_COPY_BACK_MAP;
 /* Defines the maximal length of the SSD queue  */
 extern int MAX_SSD_QUEUE_SIZE;
 
+/* Controls how the operating system merges IOs to adjacent logical addresses into larger requests */
+extern int OS_MAX_REQUEST_SIZE;
+extern double OS_PLUG_WINDOW;
+
+/* Controls the page cache of the operating system */
+extern int PAGE_CACHE_SIZE;
+extern double PAGE_CACHE_ACCESS_DELAY;
+extern double PAGE_CACHE_DIRTY_RATIO;
+extern double PAGE_CACHE_DIRTY_BACKGROUND_RATIO;
+extern int PAGE_CACHE_WRITEBACK_BATCH;
+extern int PAGE_CACHE_READAHEAD_MAX;
+
+/* Controls when a run is ended because it has reached steady state. Setting STEADY_STATE_WINDOW to 0 disables this */
+extern int STEADY_STATE_WINDOW;
+extern int STEADY_STATE_NUM_WINDOWS;
+extern double STEADY_STATE_THROUGHPUT_TOLERANCE;
+extern double STEADY_STATE_WRITE_AMPLIFICATION_TOLERANCE;
+extern double STEADY_STATE_LATENCY_TOLERANCE;
+
+/* Whether calibration workloads are run functionally, without the timing model. Only for page mapping FTLs */
+extern int FAST_FORWARD_CALIBRATION;
+
+/* Whether the hot loops run in versions compiled for the configured geometry, if there is one */
+extern int SPECIALIZE_GEOMETRY;
+
+/* Controls sampled simulation, in which only samples of the IOs are timed. Setting SAMPLING_PERIOD to 0 disables this */
+extern int SAMPLING_PERIOD;
+extern int SAMPLING_WARMUP;
+extern int SAMPLING_WINDOW;
+extern int SAMPLING_MIN_SAMPLES;
+extern double SAMPLING_TARGET_ERROR;
+
 /* Defines how the sequential writes detection algorithm spreads a sequential write  */
 extern uint LOCALITY_PARALLEL_DEGREE;
 
@@ -238,7 +275,14 @@ enum block_state{FREE, PARTIALLY_FREE, ACTIVE, INACTIVE};
  * 	                                page states set to empty)
  * 	merge - move valid pages from block at address (page state set to invalid)
  * 	           to free pages in block at merge_address */
-enum event_type{NOT_VALID, READ, READ_COMMAND, READ_TRANSFER, WRITE, ERASE, MERGE, TRIM, GARBAGE_COLLECTION, COPY_BACK, MESSAGE};
+enum event_type{NOT_VALID, READ, READ_COMMAND, READ_TRANSFER, WRITE, ERASE, MERGE, TRIM, GARBAGE_COLLECTION, COPY_BACK, MESSAGE, FSYNC};
+
+/* Zone commands of zoned devices, see ZNS_FTL
+ * 	zone_append - a write that is placed at the write pointer of the zone of its logical address.
+ * 	              The logical address is replaced by the one the write was assigned
+ * 	zone_reset - a trim that erases the zone of its logical address
+ * 	zone_finish - a trim that makes the zone of its logical address full, so it no longer counts as open */
+enum zone_command{NO_ZONE_COMMAND, ZONE_APPEND, ZONE_RESET, ZONE_FINISH};
 
 /* General return status
  * return status for simulator operations that only need to provide general
@@ -262,6 +306,9 @@ enum read_hotness {READ_HOT, READ_COLD};
 
 enum age {YOUNG, OLD};
 
+/* The tests of the SNIA Solid State Storage Performance Test Specification */
+enum pts_test {PTS_IOPS, PTS_THROUGHPUT, PTS_LATENCY};
+
 /* List classes up front for classes that have references to their "parent"
  * (e.g. a Package's parent is a Ssd).
  *
@@ -283,7 +330,9 @@ class Package;
 class FtlParent;
 class FtlImpl_Page;
 class DFTL;
+class HMB_FTL;
 class FAST;
+class ZNS_FTL;
 class Ssd;
 
 class event_queue;
@@ -307,6 +356,8 @@ class Random_Order_Iterator;
 class OperatingSystem;
 class Thread;
 class Synchronous_Writer;
+class Fio_Job_Statistics;
+class SNIA_PTS_Results;
 
 struct Address_Range;
 class Flexible_Reader;
@@ -314,6 +365,30 @@ class Flexible_Reader;
 class MTRand_int32;
 
 
+/* Converts between linear physical page addresses and the fields of an Address, for the geometry of the current SSD.
+ * Each dimension is a divisor that is applied with a shift and a mask if it is a power of two, and otherwise
+ * with a multiplication by a precomputed magic number (Granlund and Montgomery), so no conversion needs a division.
+ * Ssd::Ssd() computes it from SSD_SIZE, PACKAGE_SIZE, DIE_SIZE, PLANE_SIZE and BLOCK_SIZE. */
+class Address_Geometry {
+public:
+	static void init();
+	static inline void decode(ulong linear_address, Address& address);
+	static inline ulong encode(Address const& address);
+private:
+	struct Divisor {
+		Divisor() : divisor(1), magic(0), shift(0) {}
+		explicit Divisor(ulong divisor);
+		// Exact for dividends below 2^63
+		inline ulong divide(ulong n) const {
+			return magic == 0 ? n >> shift : (ulong)(((unsigned __int128)n * magic) >> shift);
+		}
+		ulong divisor;
+		ulong magic;  // 0 if the divisor is a power of two
+		uint shift;
+	};
+	static Divisor pages_per_block, blocks_per_plane, planes_per_die, dies_per_package;
+};
+
 /* Class to manage physical addresses for the SSD.  It was designed to have
  * public members like a struct for quick access but also have checking,
  * printing, and assignment functionality.  An instance is created for each
@@ -331,7 +406,7 @@ public:
 	inline Address(const Address &address) { *this = address; }
 	inline Address(const Address *address) { *this = *address; }
 	Address(uint package, uint die, uint plane, uint block, uint page, enum address_valid valid);
-	Address(uint address, enum address_valid valid);
+	Address(ulong address, enum address_valid valid);
 	~Address() {}
 	enum address_valid compare(const Address &address) const;
 	void print(FILE *stream = stdout) const;
@@ -369,6 +444,60 @@ public:
     }
 };
 
+inline void Address_Geometry::decode(ulong linear_address, Address& address) {
+	ulong blocks = pages_per_block.divide(linear_address);
+	address.page = linear_address - blocks * pages_per_block.divisor;
+	ulong planes = blocks_per_plane.divide(blocks);
+	address.block = blocks - planes * blocks_per_plane.divisor;
+	ulong dies = planes_per_die.divide(planes);
+	address.plane = planes - dies * planes_per_die.divisor;
+	ulong packages = dies_per_package.divide(dies);
+	address.die = dies - packages * dies_per_package.divisor;
+	address.package = packages;
+}
+
+// The fields below the valid level of the address are left out
+inline ulong Address_Geometry::encode(Address const& address) {
+	enum address_valid valid = address.valid;
+	ulong dies = (valid >= PACKAGE ? (ulong)address.package : 0) * dies_per_package.divisor + (valid >= DIE ? address.die : 0);
+	ulong planes = dies * planes_per_die.divisor + (valid >= PLANE ? address.plane : 0);
+	ulong blocks = planes * blocks_per_plane.divisor + (valid >= BLOCK ? address.block : 0);
+	return blocks * pages_per_block.divisor + (valid == PAGE ? address.page : 0);
+}
+
+inline void Address::set_linear_address(ulong address) {
+	Address_Geometry::decode(address, *this);
+}
+
+inline ulong Address::get_linear_address() const {
+	return Address_Geometry::encode(*this);
+}
+
+/* An Address packed into 64 bits: its linear address, followed by its valid level. The fields below the valid level
+ * are not kept, and unpack to 0. It is how events store physical addresses. Unpacking it costs a few shifts
+ * or multiplications, see Address_Geometry. */
+class Packed_Address
+{
+public:
+	inline Packed_Address() : bits(NONE) {}
+	inline Packed_Address(Address const& address) : bits(Address_Geometry::encode(address) << VALID_BITS | address.valid) {
+		assert((address.valid < PAGE || address.page < BLOCK_SIZE) && (address.valid < BLOCK || address.block < PLANE_SIZE)
+				&& (address.valid < PLANE || address.plane < DIE_SIZE) && (address.valid < DIE || address.die < PACKAGE_SIZE));
+	}
+	inline Address unpack() const {
+		Address address;
+		Address_Geometry::decode(bits >> VALID_BITS, address);
+		address.valid = get_valid();
+		return address;
+	}
+	inline enum address_valid get_valid() const { return (enum address_valid)(bits & VALID_MASK); }
+	inline ulong get_linear_address() const { return bits >> VALID_BITS; }
+private:
+	static const int VALID_BITS = 3;
+	static const ulong VALID_MASK = (1 << VALID_BITS) - 1;
+	ulong bits;
+};
+
 /* Class to emulate a log block with page-level mapping. */
 /*class LogPageBlock
 {
@@ -388,6 +517,66 @@ public:
 };*/
 
 
+/* Geometry traits for the hot loops of the simulator. Runtime_Geometry reads the geometry from the configuration, while
+ * Fixed_Geometry has it as constants, so that the compiler can unroll the loops over the LUNs and fold the address arithmetic.
+ * Code that is templated on the geometry is called through Geometry_Dispatch::call, which passes it the fixed geometry
+ * that matches the configuration, or Runtime_Geometry if none does. See SPECIALIZE_GEOMETRY in config.cpp. */
+struct Runtime_Geometry {
+	static const bool is_fixed = false;
+	static inline uint ssd_size() { return SSD_SIZE; }
+	static inline uint package_size() { return PACKAGE_SIZE; }
+	static inline uint die_size() { return DIE_SIZE; }
+	static inline uint plane_size() { return PLANE_SIZE; }
+	static inline uint block_size() { return BLOCK_SIZE; }
+	static inline void decode(ulong linear_address, Address& address) { Address_Geometry::decode(linear_address, address); }
+};
+
+template <uint SSD, uint PACKAGE, uint DIE, uint PLANE, uint BLOCK>
+struct Fixed_Geometry {
+	static const bool is_fixed = true;
+	static constexpr uint ssd_size() { return SSD; }
+	static constexpr uint package_size() { return PACKAGE; }
+	static constexpr uint die_size() { return DIE; }
+	static constexpr uint plane_size() { return PLANE; }
+	static constexpr uint block_size() { return BLOCK; }
+	static inline bool matches_configuration() {
+		return SSD_SIZE == SSD && PACKAGE_SIZE == PACKAGE && DIE_SIZE == DIE && PLANE_SIZE == PLANE && BLOCK_SIZE == BLOCK;
+	}
+	static inline void decode(ulong linear_address, Address& address) {
+		address.page = linear_address % BLOCK;
+		linear_address /= BLOCK;
+		address.block = linear_address % PLANE;
+		linear_address /= PLANE;
+		address.plane = linear_address % DIE;
+		linear_address /= DIE;
+		address.die = linear_address % PACKAGE;
+		address.package = linear_address / PACKAGE;
+	}
+};
+
+// The geometries of set_small_SSD_config, set_big_SSD_config and ssd.conf
+typedef Fixed_Geometry<4, 2, 1, 1024, 128> Small_Geometry;
+typedef Fixed_Geometry<8, 8, 1, 1024, 128> Big_Geometry;
+typedef Fixed_Geometry<4, 2, 1, 128, 32> Conf_File_Geometry;
+
+class Geometry_Dispatch {
+public:
+	static void init();
+	// Calls the function, which takes the geometry as its argument, with the geometry chosen by init
+	template <class Function>
+	static inline auto call(Function&& function) {
+		switch (selected) {
+		case SMALL: return function(Small_Geometry());
+		case BIG: return function(Big_Geometry());
+		case CONF_FILE: return function(Conf_File_Geometry());
+		default: return function(Runtime_Geometry());
+		}
+	}
+private:
+	enum geometry { RUNTIME, SMALL, BIG, CONF_FILE };
+	static geometry selected;
+};
+
 /* Class to manage I/O requests as events for the SSD.  It was designed to keep
  * track of an I/O request by storing its type, addressing, and timing.  The
  * SSD class creates an instance for each I/O request it receives. */
@@ -397,11 +586,13 @@ public:
 	Event(enum event_type type, ulong logical_address, uint size, double start_time);
 	Event();
 	Event(Event const& event);
-	inline virtual ~Event() {}
+	virtual ~Event();
 	inline ulong get_logical_address() const 			{ return logical_address; }
 	inline void set_logical_address(ulong addr) 		{ logical_address = addr; }
-	inline const Address &get_address() const 			{ return address; }
-	inline const Address &get_replace_address() const 	{ return replace_address; }
+	inline Address get_address() const 					{ return address.unpack(); }
+	inline Address get_replace_address() const 			{ return replace_address.unpack(); }
+	inline Packed_Address const& get_packed_address() const 		{ return address; }
+	inline Packed_Address const& get_packed_replace_address() const 	{ return replace_address; }
 	inline uint get_size() const 						{ return size; }
 	inline void set_size(int new_size)  				{ size = new_size; }
 	inline enum event_type get_event_type() const 		{ return type; }
@@ -419,7 +610,9 @@ public:
 	inline uint get_id() const 							{ return id; }
 	inline int get_tag() const 							{ return tag; }
 	inline void set_tag(int new_tag) 					{ tag = new_tag; }
-	inline void set_thread_id(int new_thread_id)		{ thread_id = new_thread_id; }
+	inline enum zone_command get_zone_command() const 	{ return zone_command; }
+	inline void set_zone_command(enum zone_command command) { zone_command = command; }
+	inline void set_thread_id(int new_thread_id)		{ get_cold_fields().thread_id = new_thread_id; }
 	inline void set_address(const Address &address) {
 		if (type == WRITE || type == READ || type == READ_COMMAND || type == READ_TRANSFER)
 			assert(address.valid == PAGE);
@@ -427,7 +620,7 @@ public:
 	}
 	inline void set_start_time(double time) 				{ start_time = time; }
 	inline void set_replace_address(const Address &address) { replace_address = address; }
-	inline void set_payload(void *payload) 					{ this->payload = payload; }
+	inline void set_payload(void *payload) 					{ get_cold_fields().payload = payload; }
 	inline void set_event_type(const enum event_type &type) { this->type = type; }
 	inline void set_noop(bool value) 						{ noop = value; }
 	inline void set_application_io_id(uint value)			{ application_io_id = value; }
@@ -440,7 +633,7 @@ public:
 	inline int get_age_class() const 						{ return age_class; }
 	inline bool is_garbage_collection_op() const 			{ return garbage_collection_op; }
 	inline bool is_mapping_op() const 						{ return mapping_op; }
-	inline void *get_payload() const 						{ return payload; }
+	inline void *get_payload() const 						{ return has_cold_fields ? cold_fields.at(id).payload : NULL; }
 	inline bool is_copyback() const 						{ return copyback; }
 	inline void incr_bus_wait_time(double time_incr) 		{ assert(time_incr >= 0); bus_wait_time += time_incr; incr_pure_ssd_wait_time(time_incr); }
 	inline void incr_pure_ssd_wait_time(double time_incr) 	{ pure_ssd_wait_time += time_incr;}
@@ -459,26 +652,20 @@ public:
 	inline int get_ssd_id() { return ssd_id; }
 	inline void set_ssd_id(int new_ssd_id) { ssd_id = new_ssd_id; }
 protected:
-	long double start_time;
+	// The layout keeps the fields the scheduler touches on every pass together, with the flags packed into bits.
+	// Fields that are rarely set are kept in a side table, see Cold_Fields.
+	double start_time;
 	double execution_time;
 	double bus_wait_time;
 	double os_wait_time;
-	enum event_type type;
 	double accumulated_wait_time;
+	double pure_ssd_wait_time;
 
 	ulong logical_address;
-	Address address;
-	Address replace_address;
+	Packed_Address address;
+	Packed_Address replace_address;
+	enum event_type type;
 	uint size;
-	void *payload;
-	bool noop;
-
-	bool garbage_collection_op;
-	bool wear_leveling_op;
-	bool mapping_op;
-	bool original_application_io;
-	bool copyback;
-	bool cached_write;
 
 	// an ID for a single IO to the chip. This is not actually used for any logical purpose
 	static uint id_generator;
@@ -492,10 +679,27 @@ protected:
 
 	int age_class;
 	int tag;
-
-	int thread_id;
-	double pure_ssd_wait_time;
 	int num_iterations_in_scheduler;
+
+	bool noop : 1;
+	bool garbage_collection_op : 1;
+	bool wear_leveling_op : 1;
+	bool mapping_op : 1;
+	bool original_application_io : 1;
+	bool copyback : 1;
+	bool cached_write : 1;
+	bool has_cold_fields : 1;
+	enum zone_command zone_command : 2;
+
+private:
+	// Fields that only a few events ever set. They are kept out of the event, keyed by its ID, and are not copied with it.
+	struct Cold_Fields {
+		Cold_Fields();
+		void *payload;
+		int thread_id;
+	};
+	Cold_Fields& get_cold_fields();
+	static unordered_map<uint, Cold_Fields> cold_fields;
 };
 
 class Message : public Event {
@@ -510,7 +714,7 @@ public:
 class Page 
 {
 public:
-	inline Page() : state(EMPTY), logical_addr(-1) {}
+	inline Page() : logical_addr(NO_LOGICAL_ADDR), state(EMPTY) {}
 	inline ~Page() {}
 	enum status _read(Event &event);
 	enum status _write(Event &event);
@@ -520,13 +724,17 @@ public:
     template<class Archive>
     void serialize(Archive & ar, const unsigned int version)
     {
-        ar & state;
+    	page_state s = state;
+        ar & s;
+        state = s;
     }
-    void set_logical_addr(int l) { logical_addr = l;}
-    int get_logical_addr() const { return logical_addr; }
+    void set_logical_addr(long l) { logical_addr = l < 0 ? NO_LOGICAL_ADDR : l; }
+    long get_logical_addr() const { return logical_addr == NO_LOGICAL_ADDR ? -1 : logical_addr; }
 private:
-	enum page_state state;
-	int logical_addr;
+	// There is a page object for every physical page, so the logical address and the state are packed into 8 bytes
+	static const ulong NO_LOGICAL_ADDR = (1UL << 56) - 1;
+	ulong logical_addr : 56;
+	enum page_state state : 8;
 };
 
 /* The block is the data storage hardware unit where erases are implemented.
@@ -551,7 +759,7 @@ public:
 	void invalidate_page(uint page);
 	inline long get_physical_address() const { return physical_address; }
 	inline Block *get_pointer() { return this; }
-	inline Page const& get_page(int i) const { return data[i]; }
+	inline Page const& get_page(int i) const { return data.empty() ? EMPTY_PAGE : data[i]; }
 	inline ulong get_age() const { return BLOCK_ERASES - erases_remaining; }
     friend class boost::serialization::access;
     template<class Archive>
@@ -564,6 +772,9 @@ public:
     	ar & erases_remaining;
     }
 private:
+	Page& get_writable_page(uint i);
+	// The pages are only allocated when the block is first written, so a block that was never written is just its counters
+	static const Page EMPTY_PAGE;
 	uint pages_invalid;
 	long physical_address;
 	vector<Page> data;
@@ -604,6 +815,7 @@ public:
 	enum status write(Event &event);
 	enum status erase(Event &event);
 	double get_currently_executing_io_finish_time();
+	inline void set_currently_executing_io_finish_time(double time) { currently_executing_io_finish_time = time; }
 	inline Plane *get_plane(int i) { return &data[i]; }
 	void clear_register();
 	int get_last_read_application_io();
@@ -812,6 +1024,82 @@ private:
 	static MTRand_int32 random_number_generator;
 };
 
+// An array over the whole address space that only allocates the chunks that have been written to, so that
+// its memory grows with the written footprint rather than with the size of the SSD. Unwritten elements
+// read as the default value, and setting an element of an unallocated chunk to the default value allocates nothing.
+template <class T>
+class Sparse_Array {
+public:
+	Sparse_Array() : num_elements(0), default_value(), chunks() {}
+	Sparse_Array(ulong num_elements, T default_value)
+		: num_elements(num_elements), default_value(default_value), chunks((num_elements + CHUNK_SIZE - 1) / CHUNK_SIZE) {}
+	inline T operator[](ulong i) const {
+		vector<T> const& chunk = chunks[i / CHUNK_SIZE];
+		return chunk.empty() ? default_value : chunk[i % CHUNK_SIZE];
+	}
+	inline void set(ulong i, T value) {
+		vector<T>& chunk = chunks[i / CHUNK_SIZE];
+		if (chunk.empty()) {
+			if (value == default_value) {
+				return;
+			}
+			chunk.assign(CHUNK_SIZE, default_value);
+		}
+		chunk[i % CHUNK_SIZE] = value;
+	}
+	inline ulong size() const { return num_elements; }
+	ulong get_num_allocated_elements() const {
+		ulong num_allocated = 0;
+		for (auto& chunk : chunks) {
+			num_allocated += chunk.size();
+		}
+		return num_allocated;
+	}
+    friend class boost::serialization::access;
+    template<class Archive>
+    void serialize(Archive & ar, const unsigned int version) {
+    	ar & num_elements;
+    	ar & default_value;
+    	ar & chunks;
+    }
+private:
+	static const ulong CHUNK_SIZE = 4096;
+	ulong num_elements;
+	T default_value;
+	vector<vector<T> > chunks;
+};
+
+// A mapping table that stores runs of consecutive logical addresses mapped to consecutive physical addresses as single extents,
+// like the compressed mapping tables of SFTL and µ-FTL. Overwriting an address in the middle of an extent splits it, and writing
+// an address that continues an extent on both the logical and physical side merges it in. Lookups are O(log n) in the number of extents.
+class Extent_Map {
+public:
+	Extent_Map() : extents() {}
+	long get(ulong logical_address) const;
+	void set(ulong logical_address, long physical_address);
+	inline ulong get_num_extents() const { return extents.size(); }
+    friend class boost::serialization::access;
+    template<class Archive>
+    void serialize(Archive & ar, const unsigned int version) {
+    	ar & extents;
+    }
+private:
+	struct Extent {
+		Extent() : length(0), physical_address(0) {}
+		Extent(ulong length, long physical_address) : length(length), physical_address(physical_address) {}
+		ulong length;
+		long physical_address;
+	    friend class boost::serialization::access;
+	    template<class Archive>
+	    void serialize(Archive & ar, const unsigned int version) {
+	    	ar & length;
+	    	ar & physical_address;
+	    }
+	};
+	void erase(ulong logical_address);
+	map<ulong, Extent> extents;  // keyed by the first logical address of each extent
+};
+
 class FtlParent
 {
 public:
@@ -825,8 +1113,8 @@ public:
 	virtual void register_write_completion(Event const& event, enum status result) = 0;
 	virtual void register_read_completion(Event const& event, enum status result) = 0;
 	virtual void register_trim_completion(Event & event) = 0;
-	virtual long get_logical_address(uint physical_address) const = 0;
-	virtual Address get_physical_address(uint logical_address) const = 0;
+	virtual long get_logical_address(ulong physical_address) const = 0;
+	virtual Address get_physical_address(ulong logical_address) const = 0;
 	virtual void set_replace_address(Event& event) const = 0;
 	virtual void set_read_address(Event& event) const = 0;
 	virtual void register_erase_completion(Event & event) {};
@@ -864,6 +1152,13 @@ protected:
 		long app_writes_per_interval;
 		long num_noop_reads;
 		long num_noop_writes;
+		long num_mapping_prefetches;
+		long num_useful_mapping_prefetches;
+		long num_wasted_mapping_prefetches;
+		int mapping_prefetch_depth;
+		long num_sram_mapping_hits;
+		long num_host_mapping_reads;
+		double host_link_wait_time;
 
 		long counter;
 		const long COUNTER_LIMIT;
@@ -885,21 +1180,27 @@ public:
 	void register_write_completion(Event const& event, enum status result);
 	void register_read_completion(Event const& event, enum status result);
 	void register_trim_completion(Event & event);
-	long get_logical_address(uint physical_address) const;
-	Address get_physical_address(uint logical_address) const;
+	long get_logical_address(ulong physical_address) const;
+	Address get_physical_address(ulong logical_address) const;
 	void set_replace_address(Event& event) const;
 	void set_read_address(Event& event) const;
+	void print() const;
+	// Stores the logical to physical mapping as extents, see Extent_Map, instead of one entry per logical page
+	static bool USE_EXTENT_MAPPING;
     friend class boost::serialization::access;
     template<class Archive>
     void serialize(Archive & ar, const unsigned int version)
     {
     	ar & boost::serialization::base_object<FtlParent>(*this);
     	ar & logical_to_physical_map;
+    	ar & logical_to_physical_extents;
     	ar & physical_to_logical_map;
     }
 private:
-	vector<long> logical_to_physical_map;
-	vector<long> physical_to_logical_map;
+	void set_physical_address(ulong logical_address, long physical_address);
+	Sparse_Array<long> logical_to_physical_map;
+	Extent_Map logical_to_physical_extents;
+	Sparse_Array<long> physical_to_logical_map;
 };
 
 
@@ -911,12 +1212,12 @@ public:
 	void register_write_completion(Event const& app_write);
 	void handle_read_dependency(Event* event);
 	void clear_clean_entries(double time);
-	int choose_dirty_victim(double time);
+	long choose_dirty_victim(double time);
 	int get_num_dirty_entries() const;
-	bool mark_clean(int key, double time);
-	int erase_victim(double time, bool allow_flushing_dirty);
-	bool contains(int key) const;
-	void set_synchronized(int key);
+	bool mark_clean(long key, double time);
+	long erase_victim(double time, bool allow_flushing_dirty);
+	bool contains(long key) const;
+	void set_synchronized(long key);
 	static int CACHED_ENTRIES_THRESHOLD;
 
 	struct entry {
@@ -943,7 +1244,7 @@ public:
 	void set_gc(flash_resident_ftl_garbage_collection* new_gc) { gc = new_gc; }
 	FtlImpl_Page* get_page_mapping() { return page_mapping; }
 	void update_bitmap(vector<bool>& bitmap, Address block_addr);
-	void set_synchronized(int logical_address);
+	void set_synchronized(long logical_address);
 protected:
 	ftl_cache* cache;
 	FtlImpl_Page* page_mapping;
@@ -962,17 +1263,24 @@ public:
 	void register_write_completion(Event const& event, enum status result);
 	void register_read_completion(Event const& event, enum status result);
 	void register_trim_completion(Event & event);
-	long get_logical_address(uint physical_address) const;
-	Address get_physical_address(uint logical_address) const;
+	long get_logical_address(ulong physical_address) const;
+	Address get_physical_address(ulong logical_address) const;
 	void set_replace_address(Event& event) const;
 	void set_read_address(Event& event) const;
 	void print() const;
 	void print_short() const;
 	static int ENTRIES_PER_TRANSLATION_PAGE;
 	static bool SEPERATE_MAPPING_PAGES;
+	// The most translation pages that are read ahead of a sequential or strided scan. 0 disables prefetching.
+	static int MAX_PREFETCH_DEPTH;
 
 private:
-	void notify_garbage_collector(int translation_page_id, double time);
+	void notify_garbage_collector(long translation_page_id, double time);
+	void register_translation_page_access(long translation_page_id, double time);
+	void prefetch_translation_page(long translation_page_id, double time);
+	void insert_in_translation_page_buffer(long translation_page_id);
+	void register_prefetch_outcome(bool was_useful);
+	bool is_die_idle(Address const& address, double time) const;
 	//bool flush_mapping(double time, bool allow_flushing_dirty);
 	//void iterate(long& victim_key, ftl_cache::entry& victim_entry, bool allow_choosing_dirty);
 	void create_mapping_read(long translation_page_id, double time, Event* dependant);
@@ -981,9 +1289,17 @@ private:
 	set<long> ongoing_mapping_operations; // contains the logical addresses of ongoing mapping IOs
 	unordered_map<long, vector<Event*> > application_ios_waiting_for_translation; // maps translation page ids to application IOs awaiting translation
 	struct mapping_page {
-		map<int, Address> entries;
+		map<long, Address> entries;
 	};
 	vector<mapping_page> mapping_pages;
+	// Translation pages that were recently read from flash and are still in SRAM, with the most recent one first.
+	// It holds twice the largest prefetch depth, so that prefetched pages are not evicted before the scan reaches them.
+	list<long> translation_page_buffer;
+	set<long> unused_prefetches;  // prefetched translation pages that no read has needed yet
+	long last_accessed_translation_page;
+	long translation_page_stride;
+	long next_translation_page_to_prefetch;
+	int prefetch_depth;
 	struct dftl_statistics {
 		map<int, int> cleans_histogram;
 		map<int, int> address_hits;
@@ -991,6 +1307,28 @@ private:
 	dftl_statistics dftl_stats;
 };
 
+// A DRAM-less DFTL, whose mapping cache lives in host memory that the host lends to the SSD (NVMe Host Memory Buffer).
+// The controller keeps the most recently used mapping entries in SRAM, and reaches the rest over the PCIe link,
+// which it shares with the data transfers of the application IOs.
+class HMB_FTL : public DFTL {
+public:
+	HMB_FTL(Ssd *ssd, Block_manager_parent* bm);
+	HMB_FTL();
+	void read(Event *event);
+	void write(Event *event);
+	void register_write_completion(Event const& event, enum status result);
+	void register_read_completion(Event const& event, enum status result);
+	static double PCIE_ROUND_TRIP_LATENCY;
+	static double PCIE_BANDWIDTH;  // in bytes per microsecond, which is MB/s
+	static const int MAPPING_ENTRY_SIZE = 8;
+private:
+	double occupy_host_link(double time, long num_bytes);
+	void insert_in_sram(long logical_address);
+	list<long> sram_entries;  // the mapping entries in SRAM, with the most recently used one first
+	unordered_map<long, list<long>::iterator> sram_entry_positions;
+	double host_link_free_time;
+};
+
 
 class FAST : public FtlParent {
 public:
@@ -1003,8 +1341,8 @@ public:
 	void register_write_completion(Event const& event, enum status result);
 	void register_read_completion(Event const& event, enum status result);
 	void register_trim_completion(Event & event);
-	long get_logical_address(uint physical_address) const;
-	Address get_physical_address(uint logical_address) const;
+	long get_logical_address(ulong physical_address) const;
+	Address get_physical_address(ulong logical_address) const;
 	void set_replace_address(Event& event) const;
 	void set_read_address(Event& event) const;
 	void register_erase_completion(Event & event);
@@ -1031,15 +1369,19 @@ private:
 	void consider_doing_garbage_collection(double time);
 
 	struct log_block {
-		log_block(Address& addr) : addr(addr), num_blocks_mapped_inside() {}
-		log_block() : addr(), num_blocks_mapped_inside() {}
+		log_block(Address& addr, bool is_sequential) : addr(addr), num_blocks_mapped_inside(), is_sequential(is_sequential), blocks_to_merge(), num_merges_left(0) {}
+		log_block() : addr(), num_blocks_mapped_inside(), is_sequential(false), blocks_to_merge(), num_merges_left(0) {}
 		Address addr;
 		set<int> num_blocks_mapped_inside;
+		bool is_sequential;  // the log block holds a single logical block, and each page is at its offset in that block
+		queue<int> blocks_to_merge;  // the logical blocks whose merges wait for a free block
+		int num_merges_left;  // the merges that are waiting or in progress
 	    friend class boost::serialization::access;
 	    template<class Archive> void
 	    serialize(Archive & ar, const unsigned int version) {
 	    	ar & addr;
 	    	ar & num_blocks_mapped_inside;
+	    	ar & is_sequential;
 	    }
 	};
 
@@ -1055,7 +1397,11 @@ private:
 	void queue_up(Event* e, Address const& lock);
 	priority_queue<log_block*, std::vector<log_block*>, mycomparison> full_log_blocks;
 	void release_events_there_was_no_space_for();
-	void garbage_collect(int block_id, log_block* log_block, double time);
+	bool try_partial_merge(int block_id, log_block* lb, double time);
+	void start_waiting_merges(log_block* lb, double time);
+	void merge(int block_id, Address const& target, log_block* lb, double time);
+	void finish_merge(int block_id, double time);
+	int get_die_id(Address const& address) const { return address.package * PACKAGE_SIZE + address.die; }
 
 	vector<Address> translation_table;		  // maps block ID to a block address in flash. This is the main mapping table
 	map<int, log_block*> active_log_blocks_map;  // Maps a block ID to the address of the corresponding log block. Used to quickly determine where to place an update
@@ -1067,6 +1413,75 @@ private:
 	FtlImpl_Page page_mapping;
 	map<int, queue<Event*> > gc_queue;
 	map<long, queue<Event*> > logical_dependencies;  // a locking table with page granularity
+	map<int, log_block*> merges_in_progress;  // maps each logical block being merged, or waiting to be, to the log block it is merged from
+	list<log_block*> log_blocks_being_merged;
+	vector<int> num_log_blocks_being_merged_per_die;
+	struct merge_statistics {
+		merge_statistics() : num_switch_merges(0), num_partial_merges(0), num_full_merges(0) {}
+		long num_switch_merges;
+		long num_partial_merges;
+		long num_full_merges;
+	};
+	merge_statistics merge_stats;
+};
+
+/* A zoned namespace (ZNS) device. The logical address space is divided into zones that must be written sequentially.
+ * Each zone is mapped to a superblock with one block from every die, and is striped across them page by page, so the
+ * mapping is a fixed function of the logical address and there is no mapping table. The host places the data, and
+ * discards it a zone at a time with zone resets, so the device does no garbage collection.
+ * A write must be at the write pointer of its zone. Writes ahead of it wait for the writes before them, which lets the
+ * IO scheduler of the OS reorder them. Zone appends are placed at the write pointer instead.
+ * At most MAX_OPEN_ZONES zones can be open. Writes that would open another zone wait until one becomes full. */
+class ZNS_FTL : public FtlParent {
+public:
+	ZNS_FTL(Ssd *ssd, Block_manager_parent* bm, Migrator* migrator);
+	ZNS_FTL();
+	~ZNS_FTL();
+	void read(Event *event);
+	void write(Event *event);
+	void trim(Event *event);
+	void register_write_completion(Event const& event, enum status result);
+	void register_read_completion(Event const& event, enum status result);
+	void register_trim_completion(Event & event);
+	long get_logical_address(ulong physical_address) const;
+	Address get_physical_address(ulong logical_address) const;
+	void set_replace_address(Event& event) const;
+	void set_read_address(Event& event) const;
+	void register_erase_completion(Event & event);
+	void print() const;
+	static long get_zone_size() { return SSD_SIZE * PACKAGE_SIZE * BLOCK_SIZE; }  // in pages
+	static long get_num_zones();
+	static int MAX_OPEN_ZONES;
+private:
+	enum zone_state {ZONE_EMPTY, ZONE_OPEN, ZONE_FULL};
+	struct zone {
+		zone() : state(ZONE_EMPTY), write_pointer(0), superblock(), waiting_writes() {}
+		zone_state state;
+		long write_pointer;            // the offset in the zone of the next write
+		vector<Address> superblock;    // the block of each die
+		map<long, Event*> waiting_writes;  // writes ahead of the write pointer, keyed by their offset
+	};
+	bool open_zone(zone& z, double time);
+	void close_zone(zone& z, double time);
+	void reset_zone(zone& z, double time);
+	void place(Event* event, zone& z);
+	void schedule_write(Event* event);
+	void release_writes_waiting_for_open_zone(double time);
+	inline int get_die_id(Address const& address) const { return address.package * PACKAGE_SIZE + address.die; }
+
+	Migrator* migrator;
+	vector<zone> zones;
+	int num_open_zones;
+	queue<Event*> writes_waiting_for_open_zone;
+	map<long, queue<Event*> > queued_writes;  // a lock for each physical block, since its pages must be written in order
+	struct zone_statistics {
+		zone_statistics() : num_appends(0), num_resets(0), num_finishes(0), num_writes_waiting_for_open_zone(0) {}
+		long num_appends;
+		long num_resets;
+		long num_finishes;
+		long num_writes_waiting_for_open_zone;
+	};
+	zone_statistics zone_stats;
 };
 
 /* The SSD is the single main object that will be created to simulate a real
@@ -1079,6 +1494,8 @@ public:
 	~Ssd();
 	void submit(Event* event);
 	void progress_since_os_is_waiting();
+	bool is_idle();
+	double get_next_event_time();
 	void register_event_completion(Event * event);
 	inline Package* get_package(int i) { return &data[i]; }
 	void set_operating_system(OperatingSystem* os);
@@ -1401,12 +1818,75 @@ private:
 	static vector<bool> has_free_pages;
 };
 
+// Watches the application throughput, write amplification and latency percentiles of the application IOs window by window,
+// as they are registered with the global statistics gatherer, and tells the operating system to stop once they have all stabilized.
+// See STEADY_STATE_WINDOW in config.cpp for the criteria. The history of the windows is printed in the results file.
+// Whenever a thread finishes, the workload changes, e.g. from preconditioning to the actual experiment, so the windows start over.
+class Steady_State_Monitor {
+public:
+	static void init();
+	static void register_completed_event(Event const& event);
+	static void register_workload_change(double time);
+	static inline bool has_reached_steady_state() { return steady_state_window != UNDEFINED; }
+	static void print(FILE* stream = stdout);
+private:
+	struct Window {
+		double throughput;            // application IOs per second
+		double write_amplification;   // flash page writes per application page write
+		double median_latency, tail_latency;
+		double end_time;
+		long num_IOs_so_far;
+	};
+	static void end_window(double time);
+	static bool is_stable(double (*metric)(Window const&), double tolerance);
+	static vector<Window> windows;
+	static vector<double> latencies;  // of the application IOs in the current window
+	static long num_app_writes, num_gc_writes, num_IOs;
+	static double window_start_time;
+	static uint first_window_of_workload;
+	static int steady_state_window;   // the last window of the first stable stretch of windows
+};
+
+// Sampled simulation, in the style of SMARTS. The operating system alternates between functional stretches, executed by the fast forwarder,
+// and detailed samples, timed by the IO scheduler with statistics recorded. Each sample starts with warm-up IOs, which fill the queues again
+// and are not measured. The estimates are the averages over the samples, with 95% confidence intervals from the spread of the samples.
+// See SAMPLING_PERIOD in config.cpp. Like for the steady state monitor, the samples start over whenever the workload changes.
+class Sampled_Simulation {
+public:
+	static void init();
+	static void register_completed_event(Event const& event);
+	static void register_workload_change();
+	static inline bool is_functional() { return phase == FUNCTIONAL; }
+	static void print(FILE* stream = stdout);
+private:
+	enum sampling_phase { FUNCTIONAL, WARMING_UP, MEASURING };
+	struct Sample {
+		double throughput;   // application IOs per second
+		double mean_latency, median_latency, latency_95th, latency_99th;
+		double end_time;
+	};
+	struct Estimate {
+		double mean;
+		double error;        // half width of the 95% confidence interval
+		long samples_needed; // for the error to be within SAMPLING_TARGET_ERROR of the mean
+	};
+	static void end_sample(double time);
+	static Estimate estimate(double (*metric)(Sample const&));
+	static vector<Sample> samples;
+	static vector<double> latencies;  // of the application IOs measured in the current sample
+	static sampling_phase phase;
+	static long num_IOs_in_phase, num_functional_IOs, num_detailed_IOs;
+	static long period;
+	static double sample_start_time;
+};
+
 class Individual_Threads_Statistics {
 public:
 	static void init();
 	static void print();
 	static void register_thread(Thread*, string name);
 	static StatisticsGatherer* get_stats_for_thread(int index);
+	static string get_thread_name(int index);
 	static int size();
 private:
 	static vector<Thread*> threads;
@@ -1539,6 +2019,85 @@ public:
 	vector<Thread*> generate();
 };
 
+// This workload is a key-value store based on a log-structured merge tree that spans the whole logical address space.
+// It appends to a write-ahead log, flushes memtables into files, and compacts the files level by level, trimming whole files.
+// Every file is written with its own tag, so it is meant to be run with ENABLE_TAGGING. A write_rate of UNDEFINED does not throttle the log.
+class LSM_Compaction_Workload : public Workload_Definition {
+public:
+	LSM_Compaction_Workload(int file_size = 64, int level_fanout = 10, double write_rate = UNDEFINED);
+	vector<Thread*> generate();
+private:
+	int file_size, level_fanout;
+	double write_rate;
+};
+
+// This workload is an OLTP database engine with a B-tree. The first 5% of the logical address space is a write-ahead log,
+// which a synchronous sequential writer appends to one page per commit. The rest holds the database pages, which
+// synchronous random readers read, and a checkpoint thread writes back in bursts.
+// The log writer and the checkpoint thread are registered separately, so that commit latency is reported apart from checkpoint throughput.
+class OLTP_Workload : public Workload_Definition {
+public:
+	OLTP_Workload(double dirty_page_rate = 5000, double checkpoint_interval = 100000, int num_readers = 4);
+	vector<Thread*> generate();
+private:
+	double dirty_page_rate;      // database pages per second
+	double checkpoint_interval;  // in microseconds
+	int num_readers;
+};
+
+// Runs the jobs of a fio job file in parallel, so that workloads can be described without writing C++.
+// The supported options are rw, rwmixread, rwmixwrite, bs, iodepth, numjobs, size, offset, rate_iops, runtime,
+// time_based, number_ios, random_distribution (random, zipf or pareto), randseed and group_reporting.
+// Options in the [global] section apply to the jobs that follow it. Sizes and offsets are relative to the logical address space.
+class Fio_Workload : public Workload_Definition {
+public:
+	Fio_Workload(string job_file_name);
+	~Fio_Workload();
+	vector<Thread*> generate();
+	void print_json(FILE* stream) const;
+private:
+	struct Fio_Job {
+		string name;
+		map<string, string> options;
+		inline bool has(string option) const { return options.count(option) == 1; }
+		inline string get(string option, string default_value) const { return has(option) ? options.at(option) : default_value; }
+	};
+	void parse(string job_file_name);
+	long parse_size(Fio_Job const& job, string option, long default_value) const;  // in bytes
+	static double parse_time(Fio_Job const& job, string option);                     // in microseconds
+	static const set<string> supported_options, ignored_options;
+	vector<Fio_Job> jobs;
+	vector<pair<int, Fio_Job_Statistics*> > statistics;  // the index of the job, and the statistics of one of its clones or of all of them
+};
+
+// Runs one test of the SNIA Solid State Storage Performance Test Specification over the logical address space,
+// with queue_depth outstanding IOs, or one for the latency test if it is UNDEFINED, and 32 for the others.
+// The test preconditions the SSD itself, and runs until steady state or for at most SNIA_PTS_Results::MAX_ROUNDS rounds,
+// so it should be run without an IO limit. write_results writes the CSV reports of the test into a folder.
+class SNIA_PTS_Workload : public Workload_Definition {
+public:
+	SNIA_PTS_Workload(pts_test test, int queue_depth = UNDEFINED, double point_duration = 10000);
+	~SNIA_PTS_Workload();
+	vector<Thread*> generate();
+	void write_results(string folder_name) const;
+private:
+	pts_test test;
+	int queue_depth;
+	double point_duration;  // in microseconds
+	SNIA_PTS_Results* results;
+};
+
+// Writes the logical address space sequentially before the threads of another workload start,
+// so that workloads that read, like fio jobs, never read unwritten pages. The other workload is deleted with this one.
+class Preconditioned_Workload : public Workload_Definition {
+public:
+	Preconditioned_Workload(Workload_Definition* workload);
+	~Preconditioned_Workload();
+	vector<Thread*> generate();
+private:
+	Workload_Definition* workload;
+};
+
 class Experiment {
 public:
 	Experiment();
@@ -1565,8 +2124,8 @@ public:
 	void run(string experiment_name);
 	void run_single_point(string name);
 	static vector<Experiment_Result> random_writes_on_the_side_experiment(Workload_Definition* workload, int write_threads_min, int write_threads_max, int write_threads_inc, string name, int IO_limit, double used_space, int random_writes_min_lba, int random_writes_max_lba);
-	static Experiment_Result copyback_experiment(vector<Thread*> (*experiment)(int highest_lba), int used_space, int max_copybacks, string data_folder, string name, int IO_limit);
-	static Experiment_Result copyback_map_experiment(vector<Thread*> (*experiment)(int highest_lba), int cb_map_min, int cb_map_max, int cb_map_inc, int used_space, string data_folder, string name, int IO_limit);
+	static Experiment_Result copyback_experiment(vector<Thread*> (*experiment)(long highest_lba), int used_space, int max_copybacks, string data_folder, string name, int IO_limit);
+	static Experiment_Result copyback_map_experiment(vector<Thread*> (*experiment)(long highest_lba), int cb_map_min, int cb_map_max, int cb_map_inc, int used_space, string data_folder, string name, int IO_limit);
 	void set_exponential_increase(bool e) { exponential_increase = e; }
 	void draw_graphs();
 	void draw_aggregate_graphs();
@@ -1580,6 +2139,7 @@ public:
 	static string get_base_directory() { return base_folder; }
 	void set_variable(double* variable, double low, double high, double incr, string variable_name);
 	void set_variable(int* variable, int low, int high, int incr, string variable_name);
+	void set_grid(vector<string> knob_names, vector<vector<double> > points);
 	void set_workload(Workload_Definition* w) { workload = w; }
 	void set_calibration_workload(Workload_Definition* w) { calibrate_for_each_point = true; calibration_workload = w; }
 	void set_io_limit(int limit) { io_limit = limit; };
@@ -1594,6 +2154,11 @@ private:
 	int* i_variable;
 	int i_min, i_max, i_incr;
 
+	// Each point of the grid sets all the knobs by their configuration names
+	vector<string> grid_knob_names;
+	vector<vector<double> > grid_points;
+	void grid_experiment(string name);
+
 	int io_limit;
 	Workload_Definition* workload;
 	Workload_Definition* calibration_workload;
@@ -1618,6 +2183,36 @@ private:
 	bool exponential_increase;
 };
 
+// An experiment described by a spec file, so that sweeps can be generated by scripts and run in batch without writing C++.
+// Every line is either a configuration knob with its value, like in ssd.conf, or one of these directives:
+//   name <name>                       the folder of the results, in the base folder
+//   io_limit <number of IOs>          each point stops after this many IOs
+//   workload <name> [arguments]       one of the workloads listed in create_workload
+//   precondition <0 or 1>             write the logical address space sequentially before the workload starts
+//   vary <knob> <values>              a sweep variable, with the values it takes
+//   sweep <cartesian or zip>          whether the points are all combinations of the values of the sweep variables,
+//                                     or the first values of each, then the second values, and so on. The default is cartesian.
+//   draw_graphs <0 or 1>              draw graphs of the results with gle
+// Knobs are set in the order in which they appear, and the sweep variables are set again at every point.
+class Experiment_Spec {
+public:
+	Experiment_Spec(string file_name);
+	~Experiment_Spec();
+	void run();
+	vector<vector<double> > get_points() const;
+private:
+	void parse(string file_name);
+	static Workload_Definition* create_workload(vector<string> const& arguments, int line_number);
+	string name;
+	long io_limit;
+	Workload_Definition* workload;
+	bool precondition;
+	bool is_cartesian;
+	bool draw_graphs;
+	vector<string> knob_names;
+	vector<vector<double> > knob_values;
+};
+
 class MTRand_int32 { // Mersenne Twister random number generator
 public:
 // default constructor: uses default seed only if this is the first instance
@@ -1632,6 +2227,8 @@ public:
   void seed(const unsigned long*, int size); // seed with array
 // overload operator() to make this a generator (functor)
   unsigned long operator()() { return rand_int32(); }
+// random integer in [0, limit), which takes two 32 bit numbers if the limit does not fit in 32 bits
+  unsigned long below(unsigned long limit);
 // 2007-02-11: made the destructor virtual; thanks "double more" for pointing this out
   virtual ~MTRand_int32() {} // destructor
 
@@ -1679,6 +2276,12 @@ inline unsigned long MTRand_int32::rand_int32() { // generate 32 bit random int
   return x ^ (x >> 18);
 }
 
+inline unsigned long MTRand_int32::below(unsigned long limit) {
+  if (limit <= 0x100000000UL) return rand_int32() % limit;
+  unsigned long high = rand_int32();
+  return ((high << 32) | rand_int32()) % limit;
+}
+
 // generates double floating point numbers in the half-open interval [0, 1)
 class MTRand : public MTRand_int32 {
 public: